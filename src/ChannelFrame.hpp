@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+
+/*!
+\brief	One sample of N interleaved float channels (e.g. mono/diff, L/R or several stations).
+        Used as the sample type of FIRFilter, each coefficient is loaded once and applied to all
+        lanes. ChannelFrame<2> has the same layout as std::complex<float>.
+*/
+template <size_t N>
+struct ChannelFrame {
+    float ch[N];
+
+    float& operator[](size_t i) { return ch[i]; }
+    const float& operator[](size_t i) const { return ch[i]; }
+
+    ChannelFrame& operator+=(const ChannelFrame& o) {
+        for (size_t i = 0; i < N; i++) ch[i] += o.ch[i];
+        return *this;
+    }
+
+    friend ChannelFrame operator+(ChannelFrame a, const ChannelFrame& b) { return a += b; }
+
+    friend ChannelFrame operator*(ChannelFrame a, float g) {
+        for (size_t i = 0; i < N; i++) a.ch[i] *= g;
+        return a;
+    }
+};
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <cmath>
+#include <cstdint>
+#include <bit>
+#include <algorithm>
+
+/*!
+\brief	Read-only FIR coefficients in time order (oldest sample first), 64-byte aligned, with the
+        properties filters need at run time computed once.
+*/
+class TapSet {
+public:
+    explicit TapSet(std::span<const float> taps)
+        : n(taps.size()), lines((taps.size() + 15) / 16 + 1) {
+        float* dst = reinterpret_cast<float*>(lines.data());
+        std::reverse_copy(taps.begin(), taps.end(), dst);
+
+        float peak = 0.0f;
+        for (float t : taps) {
+            peak = std::max(peak, std::abs(t));
+            gain += t;
+        }
+
+        // Linear-phase check, tolerance is relative to the largest coefficient
+        symmetric = n > 1;
+        for (size_t k = 0; k < n / 2; k++) {
+            if (std::abs(taps[k] - taps[n - 1 - k]) > 1e-6f * peak) symmetric = false;
+        }
+    }
+
+    const float* data() const { return reinterpret_cast<const float*>(lines.data()); }
+    size_t size() const { return n; }
+    bool is_symmetric() const { return symmetric; }
+    float dc_gain() const { return gain; }
+
+    // Bit-exact comparison against taps in time order
+    bool matches(std::span<const float> taps) const {
+        if (taps.size() != n) return false;
+        const float* rev = data();
+        for (size_t k = 0; k < n; k++) {
+            if (std::bit_cast<uint32_t>(taps[k]) != std::bit_cast<uint32_t>(rev[n - 1 - k])) return false;
+        }
+        return true;
+    }
+
+private:
+    struct alignas(64) CacheLine { float v[16]; };
+
+    size_t n;
+    std::vector<CacheLine> lines;       // zero padded to whole cache lines
+    bool symmetric = false;
+    float gain = 0.0f;
+};
+
+/*!
+\brief	Process-wide store that hands out one shared TapSet per distinct coefficient set, so
+        filters built from the same table do not each hold a private copy. Entries are keyed by a
+        hash of the taps and confirmed against the TapSet itself, expired entries are dropped on
+        the next acquire().
+*/
+class CoefficientStore {
+public:
+    static std::shared_ptr<const TapSet> acquire(std::span<const float> taps) {
+        const uint64_t key = hash(taps);
+        std::lock_guard<std::mutex> lock(mutex());
+        auto& map = entries();
+
+        std::shared_ptr<const TapSet> hit;
+        for (auto it = map.begin(); it != map.end();) {
+            std::shared_ptr<const TapSet> set = it->second.lock();
+            if (!set) {
+                it = map.erase(it);
+                continue;
+            }
+            if (!hit && it->first == key && set->matches(taps)) hit = set;
+            ++it;
+        }
+        if (hit) return hit;
+
+        auto set = std::make_shared<const TapSet>(taps);
+        map.emplace(key, set);
+        return set;
+    }
+
+    // Entries currently held, live or expired since the last acquire()
+    static size_t size() {
+        std::lock_guard<std::mutex> lock(mutex());
+        return entries().size();
+    }
+
+private:
+    // FNV-1a over the bit patterns
+    static uint64_t hash(std::span<const float> taps) {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (float t : taps) {
+            h ^= std::bit_cast<uint32_t>(t);
+            h *= 0x100000001b3ull;
+        }
+        return h;
+    }
+
+    static std::mutex& mutex() {
+        static std::mutex mtx;
+        return mtx;
+    }
+
+    static std::multimap<uint64_t, std::weak_ptr<const TapSet>>& entries() {
+        static std::multimap<uint64_t, std::weak_ptr<const TapSet>> map;
+        return map;
+    }
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <string>
+#include <cstdio>
+
+/*!
+\brief	Keeps the audio ring fill flat when the dongle crystal and the sound card clock disagree.
+        The broadcast pilot is 19kHz against the station reference, so the PLL frequency measured
+        in dongle samples gives the dongle error directly (feed forward). What is left, mostly the
+        sound card error, is removed by a slow PI loop on the smoothed ring fill. The result is the
+        ratio scale of the variable output resampler: input samples consumed per output sample,
+        relative to nominal.
+*/
+class DriftCompensator {
+public:
+    static constexpr double kPilotHz = 19000.0;
+    static constexpr double kMaxPilotPpm = 300.0;   // larger offsets are a bad lock, not a crystal
+    static constexpr double kMaxPpm = 1000.0;       // total correction limit, matches PolyphaseResampler::kMaxTrim
+
+    double pilot_tau = 10.0;    // pilot frequency averaging, seconds
+    double fill_tau = 1.0;      // ring fill smoothing, seconds
+    double loop_tau = 60.0;     // PI loop time constant, seconds, critically damped
+
+    /*!
+    \param 		out_rate - Sink rate in frames per second
+    \param 		target_fill - Ring fill to hold, in frames
+    */
+    DriftCompensator(double out_rate, double target_fill) : fo(out_rate), target(target_fill) {}
+
+    /*!
+    \brief		Update after producing a block, returns the ratio scale for the resampler
+    \param 		frames - Frames produced at the output rate since the last update
+    \param 		fill - Current ring fill in frames
+    \param 		pilot_hz - Pilot PLL frequency, used when pilot_valid
+    */
+    double update(size_t frames, double fill, double pilot_hz, bool pilot_valid) {
+        const double dt = frames / fo;
+        if (dt <= 0.0) return scale();
+
+        // Dongle error from the pilot, a fast dongle sees a low pilot
+        const double ppm = (kPilotHz / pilot_hz - 1.0) * 1e6;
+        if (pilot_valid && std::abs(ppm) < kMaxPilotPpm) {
+            dongle_ppm = has_pilot ? dongle_ppm + (ppm - dongle_ppm) * std::min(1.0, dt / pilot_tau) : ppm;
+            has_pilot = true;
+        }
+
+        // PI on the relative fill error, plant is an integrator with gain fo frames/s per unit ratio
+        smooth_fill = has_fill ? smooth_fill + (fill - smooth_fill) * std::min(1.0, dt / fill_tau) : fill;
+        has_fill = true;
+        const double err = (smooth_fill - target) / fo;       // seconds of audio above target
+        const double wn = 1.0 / loop_tau;
+        integral = std::clamp(integral + wn * wn * err * dt, -kMaxPpm * 1e-6, kMaxPpm * 1e-6);
+        trim_ppm = (2.0 * wn * err + integral) * 1e6;
+
+        correction_ppm = std::clamp(dongle_ppm + trim_ppm, -kMaxPpm, kMaxPpm);
+        max_abs_ppm = std::max(max_abs_ppm, std::abs(correction_ppm));
+        min_fill = std::min(min_fill, fill);
+        max_fill = std::max(max_fill, fill);
+        return scale();
+    }
+
+    // Move the fill set point, e.g. when the sink priming target adapts
+    void set_target(double target_fill) { target = target_fill; }
+
+    // Input step scale, > 1 when the producer runs fast relative to the sink
+    double scale() const { return 1.0 + correction_ppm * 1e-6; }
+
+    // Restart the fill statistics window, the loop state is kept
+    void reset_stats() { min_fill = max_fill = smooth_fill; max_abs_ppm = std::abs(correction_ppm); }
+
+    std::string describe() const {
+        char buf[192];
+        std::snprintf(buf, sizeof(buf), "dongle %+.1f ppm%s, sink trim %+.1f ppm, correction %+.1f ppm (max %.1f), fill %.0f [%.0f, %.0f] of %.0f frames",
+                      dongle_ppm, has_pilot ? "" : " (no pilot)", trim_ppm, correction_ppm, max_abs_ppm,
+                      smooth_fill, min_fill, max_fill, target);
+        return buf;
+    }
+
+    double dongle_ppm = 0.0;        // pilot derived dongle clock error
+    double trim_ppm = 0.0;          // PI output, sink clock error and residual
+    double correction_ppm = 0.0;    // applied ratio correction
+    double smooth_fill = 0.0;       // ring fill, frames
+
+private:
+    double fo, target;
+    double integral = 0.0;
+    double max_abs_ppm = 0.0;
+    double min_fill = 1e30, max_fill = 0.0;
+    bool has_pilot = false, has_fill = false;
+};
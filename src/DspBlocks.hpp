@@ -1,6 +1,19 @@
 #include <complex>
 #include <cmath>
 #include <algorithm>
+#include <span>
+#include <vector>
+#include <array>
+#include "SimdKernels.hpp"
+#include "PilotNco.hpp"
+#include "ChannelFrame.hpp"
+#include "FFTFilter.hpp"
+
+// One biquad section, y = b0 x + b1 x1 + b2 x2 - a1 y1 - a2 y2 (a0 normalized to 1)
+struct BiquadCoeffs {
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+};
+
 
 // IQ DC Blocker (Notch at 0Hz)
 struct IQDcBlocker {
@@ -18,7 +31,19 @@ struct IQDcBlocker {
 
 // FM Quadrature Demodulator
 struct FmDemod {
+    // Phase discriminator, selectable at run time
+    enum class Mode {
+        Atan2,      // exact std::atan2 of x * conj(prev)
+        FastAtan2,  // vectorized polynomial atan2, |error| < 2e-6 rad (below -110 dB of full deviation)
+        Quotient    // (I*dQ - Q*dI) / |x|^2, no trig: returns ~sin(dphi), 15% low at 75 kHz deviation and 480 kS/s
+    };
+
+    Mode mode = Mode::Atan2;
     std::complex<float> prev{1.0f, 0.0f};
+    std::vector<float> re_buf, im_buf;      // block scratch
+
+    FmDemod() = default;
+    explicit FmDemod(Mode m) : mode(m) {}
 
     float push(std::complex<float> x) {
         // Calculate phase difference between current sample (x) and previous (prev)
@@ -28,50 +53,280 @@ struct FmDemod {
         
         prev = x; // Update state
 
-        // Standard atan2 extracts the exact angle in radians (-pi to +pi)
-        return std::atan2(im, re);
+        switch (mode) {
+            case Mode::FastAtan2:
+                return simd::atan2_poly(im, re);
+            case Mode::Quotient:
+                return im / (std::norm(x) + 1e-20f);
+            default:
+                // Standard atan2 extracts the exact angle in radians (-pi to +pi)
+                return std::atan2(im, re);
+        }
+    }
+
+    // Demodulate a block, out needs room for in.size() samples
+    size_t process(std::span<const std::complex<float>> in, std::span<float> out) {
+        const size_t n = in.size();
+        if (n == 0) return 0;
+        re_buf.resize(std::max(re_buf.size(), n));
+        im_buf.resize(re_buf.size());
+
+        // x[i] * conj(x[i-1]) as separate real / imaginary lanes
+        std::complex<float> p = prev;
+        for (size_t i = 0; i < n; i++) {
+            const std::complex<float> x = in[i];
+            re_buf[i] = x.real() * p.real() + x.imag() * p.imag();
+            im_buf[i] = x.imag() * p.real() - x.real() * p.imag();
+            p = x;
+        }
+        prev = p;
+
+        switch (mode) {
+            case Mode::FastAtan2:
+                simd::kernels().atan2_f32(im_buf.data(), re_buf.data(), out.data(), n);
+                break;
+            case Mode::Quotient:
+                for (size_t i = 0; i < n; i++) out[i] = im_buf[i] / (std::norm(in[i]) + 1e-20f);
+                break;
+            default:
+                for (size_t i = 0; i < n; i++) out[i] = std::atan2(im_buf[i], re_buf[i]);
+                break;
+        }
+        return n;
     }
 };
 
 
+// Pilot presence detector - Goertzel at 19kHz against 17kHz and 21kHz in the empty guard band,
+// evaluated over 10ms windows with hysteresis so weak or fading pilots do not toggle the mode
+struct PilotDetector {
+    float on_db = 15.0f;        // pilot to guard band ratio to enter stereo
+    float off_db = 8.0f;        // ratio below which stereo is dropped
+    int hold = 3;               // consecutive windows needed to change state
+
+    int window;                 // samples per evaluation
+    float c_pilot, c_lo, c_hi;  // Goertzel coefficients 2cos(w)
+    float p1 = 0, p2 = 0, l1 = 0, l2 = 0, h1 = 0, h2 = 0;
+    int count = 0, votes = 0;
+
+    float level_db = 0.0f;      // last measured pilot to guard ratio
+    bool present = false;
+
+    PilotDetector(float sampleRate) : window(std::max(1, (int)std::lround(sampleRate / 100.0f))) {
+        auto coeff = [&](float f) {
+            // snap to the nearest bin of the window so each tone sees a whole number of cycles
+            const float k = std::round(f * window / sampleRate);
+            return 2.0f * std::cos(2.0f * 3.141592654f * k / window);
+        };
+        c_pilot = coeff(19000.0f);
+        c_lo = coeff(17000.0f);
+        c_hi = coeff(21000.0f);
+    }
+
+    // Returns true when a window completed and present / level_db were updated
+    bool push(float x) {
+        const float p0 = x + c_pilot * p1 - p2;
+        const float l0 = x + c_lo * l1 - l2;
+        const float h0 = x + c_hi * h1 - h2;
+        p2 = p1; p1 = p0;
+        l2 = l1; l1 = l0;
+        h2 = h1; h1 = h0;
+        if (++count < window) return false;
+
+        const float pilot = p1 * p1 + p2 * p2 - c_pilot * p1 * p2;
+        const float guard = 0.5f * ((l1 * l1 + l2 * l2 - c_lo * l1 * l2) + (h1 * h1 + h2 * h2 - c_hi * h1 * h2));
+        level_db = 10.0f * std::log10((pilot + 1e-20f) / (guard + 1e-20f));
+        p1 = p2 = l1 = l2 = h1 = h2 = 0.0f;
+        count = 0;
+
+        // Hysteresis, the opposite state must win several windows in a row
+        const bool vote = present ? (level_db < off_db) : (level_db > on_db);
+        votes = vote ? votes + 1 : 0;
+        if (votes >= hold) {
+            present = !present;
+            votes = 0;
+        }
+        return true;
+    }
+
+    // Forget the station, e.g. after a retune
+    void reset() {
+        p1 = p2 = l1 = l2 = h1 = h2 = 0.0f;
+        count = votes = 0;
+        level_db = 0.0f;
+        present = false;
+    }
+};
+
+
+/*!
+\brief	Pilot PLL and 38kHz stereo demodulation. After construction or reacquire() the loop is not
+        left to pull in from a stale phase: PilotAcquirer measures the pilot, the loop is seeded once
+        the detector confirms it, runs wide pull-in gains and switches to the tracking gains when the
+        phase error over a detector window is small. Stereo is enabled at that lock.
+*/
 struct StereoSeparator {
+    enum class PilotState { Acquire, PullIn, Track };
+
     // PLL
-    float alpha = 0.01f;    // Loop gain
-    float beta = 0.0001f;   // Integrator gain
-    float phase = 0.0f;
-    float freq = 19000.0f;  // Estimated pilot freq
-    float freq_nominal = 19000.0f;
-    float sampleRate;
+    PilotNco pilot;
+    std::vector<PilotCarriers> carrier_block;   // carriers of the last process() block
+
+    // Acquisition
+    PilotAcquirer acquirer;
+    bool fast_acquire = true;           // false: the loop free-runs until the detector sees a pilot and pulls in from there
+    float pull_in_alpha = 0.04f;        // loop gains between seeding and lock
+    float pull_in_beta = 0.004f;
+    float lock_rad = 0.2f;              // phase error that counts as locked
+    int max_pull_in = 10;               // detector windows without lock before measuring again
+    PilotState state = PilotState::Acquire;
+    float lock_ms = -1.0f;              // new station (reacquire() past its stale samples) or pilot loss to lock, -1 while acquiring
+    int locks = 0;                      // completed acquisitions
 
     // Stereo
-    float pilot_lock_level = 0.0f; 
-    bool is_stereo = false;
+    PilotDetector detector;
+    float pilot_lock_level = 0.0f;      // pilot to guard band ratio in dB
+    bool is_stereo = false;             // false: L-R is not demodulated, diff output is 0
 
-    StereoSeparator(float fs) : sampleRate(fs) {}
+    StereoSeparator(float fs)
+        : pilot(fs), acquirer(fs, std::max(1, (int)std::lround(fs / 100.0f))), detector(fs),
+          track_alpha(pilot.alpha), track_beta(pilot.beta) { pilot.hold = true; }
 
     // Returns pair {L+R (Mono), L-R (Stereo Diff)} from raw RF input signal
     std::pair<float, float> process(float x) {
-
-        // PLL - Update Phase
-        float dt = 1.0f / sampleRate;
-        phase += freq * dt * 2.0f * 3.141592654f;
-        if (phase > 2.0f * 3.141592654f) phase -= 2.0f * 3.141592654f;
-
-        // PLL - Calculate Error
-        float pll_error = x * std::sin(phase); 
-
-        // PLL - Update Frequency
-        freq += beta * pll_error;
-        phase += alpha * pll_error;     // adjust phase to lock
+        const std::complex<float> c19 = step(x);
+        if (!is_stereo) return {x, 0.0f};
 
         // Generate 38kHz Carrier
-        float carrier = std::sin(2.0f * phase) * 2.0f;
+        float carrier = PilotNco::mul(c19, c19).imag() * 2.0f;
 
         // Demodulate
         float diff = x * carrier;
 
         return {x, diff};
     }
+
+    // Block version, out[i] = {L+R, L-R}. The pilot carriers of the block are published in carriers().
+    // The stereo decision is taken per block, mono blocks skip the 38kHz demodulation
+    size_t process(std::span<const float> in, std::span<ChannelFrame<2>> out) {
+        carrier_block.resize(in.size());
+        if ((!fast_acquire || state == PilotState::Track) && stale == 0) {
+            pilot.process(in, carrier_block);
+            for (float x : in) {
+                if (detector.push(x)) update_mode();
+            }
+        }
+        else {
+            for (size_t i = 0; i < in.size(); i++) {
+                const std::complex<float> c19 = step(in[i]);
+                const std::complex<float> c38 = PilotNco::mul(c19, c19);
+                carrier_block[i] = {c19, c38, PilotNco::mul(c38, c19)};
+            }
+        }
+
+        if (!is_stereo) {
+            for (size_t i = 0; i < in.size(); i++) out[i] = {in[i], 0.0f};
+            return in.size();
+        }
+        for (size_t i = 0; i < in.size(); i++) {
+            out[i] = {in[i], in[i] * carrier_block[i].c38.imag() * 2.0f};
+        }
+        return in.size();
+    }
+
+    std::span<const PilotCarriers> carriers() const { return carrier_block; }
+
+    // New station: drop the pilot decision and acquire from scratch, lock_ms then times the acquisition.
+    // stale_samples are still queued from the old station, they pass as mono but never reach the loop,
+    // the acquirer or the detector, so the old pilot cannot be seeded on
+    void reacquire(size_t stale_samples = 0) {
+        detector.reset();
+        is_stereo = false;
+        enter_acquire();
+        stale = stale_samples;
+    }
+
+private:
+    // One MPX sample through the loop, the acquisition and the detector
+    std::complex<float> step(float x) {
+        const std::complex<float> c19 = pilot.step(x);
+        if (stale > 0) {
+            stale--;
+            return c19;
+        }
+        if (fast_acquire && state != PilotState::Track) acquire(x, c19);
+        if (detector.push(x)) update_mode();
+        return c19;
+    }
+
+    void acquire(float x, std::complex<float> c19) {
+        acq_samples++;
+        acquirer.push(x);
+        if (state != PilotState::PullIn) return;
+
+        // x sin(phase) drives the loop to the anti-phase of the cos() pilot, x e^{j phase} averages to -A/2 there
+        lock_sum += x * c19;
+        if (++lock_n < detector.window) return;
+        const float err = std::arg(-lock_sum);
+        lock_sum = {};
+        lock_n = 0;
+        if (std::abs(err) < lock_rad) {
+            state = PilotState::Track;
+            pilot.alpha = track_alpha;
+            pilot.beta = track_beta;
+            lock_ms = 1e3f * (float)acq_samples / pilot.sampleRate;
+            locks++;
+            is_stereo = detector.present;
+        }
+        else if (++pull_in_windows >= max_pull_in) {
+            enter_acquire();
+        }
+    }
+
+    void enter_acquire() {
+        state = PilotState::Acquire;
+        pilot.alpha = track_alpha;
+        pilot.beta = track_beta;
+        pilot.hold = true;
+        acquirer.reset();
+        acq_samples = 0;
+        lock_ms = -1.0f;
+    }
+
+    // Start the loop on the measured pilot, in the anti-phase it settles to
+    void seed() {
+        pilot.seed((float)acquirer.freq, (float)(acquirer.phase() + 3.14159265358979));
+        pilot.alpha = pull_in_alpha;
+        pilot.beta = pull_in_beta;
+        pilot.hold = false;
+        state = PilotState::PullIn;
+        lock_sum = {};
+        lock_n = pull_in_windows = 0;
+    }
+
+    // Without a pilot the PLL would only chase program audio and noise, so it free-runs instead
+    void update_mode() {
+        pilot_lock_level = detector.level_db;
+        if (!fast_acquire) {
+            is_stereo = detector.present;
+            pilot.hold = !is_stereo;
+            return;
+        }
+
+        if (!detector.present) {
+            if (state != PilotState::Acquire) enter_acquire();
+        }
+        else if (state == PilotState::Acquire && acquirer.valid) {
+            seed();
+        }
+        is_stereo = detector.present && state == PilotState::Track;
+    }
+
+    float track_alpha, track_beta;      // loop gains once locked
+    uint64_t acq_samples = 0;           // samples since acquisition started
+    std::complex<float> lock_sum{};     // x e^{j phase} over the current lock window
+    int lock_n = 0, pull_in_windows = 0;
+    size_t stale = 0;                   // old station samples left to pass after reacquire()
 };
 
 
@@ -109,6 +364,8 @@ struct NotchFilter19k {
 
         return y;
     }
+
+    BiquadCoeffs coeffs() const { return {b0, b1, b2, a1, a2}; }
 };
 
 
@@ -116,12 +373,19 @@ struct NotchFilter19k {
 struct DcBlocker {
     float y = 0.0f, x1 = 0.0f;
     float R = 0.995f; // 0.99–0.999, tune if needed
+
+    DcBlocker() = default;
+    // Same ~380Hz corner as the default R at 480kS/s, for other MPX rates
+    explicit DcBlocker(float sampleRate) : R(1.0f - 0.005f * 480000.0f / sampleRate) {}
+
     float push(float x) {
         float out = x - x1 + R * y;
         x1 = x;
         y = out;
         return out;
     }
+
+    BiquadCoeffs coeffs() const { return {1.0f, -1.0f, 0.0f, -R, 0.0f}; }
 };
 
 
@@ -154,6 +418,8 @@ struct DeemphasisBiquad {
         y1 = y;
         return y;
     }
+
+    BiquadCoeffs coeffs() const { return {b0, b1, 0.0f, a1, 0.0f}; }
 };
 
 
@@ -186,4 +452,143 @@ inline float softclip(float x) {
 }
 
 
+// Multi-lane biquad cascade. Every sample carries one value per lane (L/R, mono/diff or several
+// stations), each section has its own coefficients per lane and lanes run side by side, so the
+// inner lane loops map onto SIMD registers. Whole blocks are filtered in place.
+template <size_t Lanes>
+class BiquadBank {
+public:
+    // Append a section with the same coefficients on every lane
+    void add(const BiquadCoeffs& c) {
+        std::array<BiquadCoeffs, Lanes> per_lane;
+        per_lane.fill(c);
+        add(per_lane);
+    }
+
+    // Append a section with per-lane coefficients, BiquadCoeffs{} passes a lane through
+    void add(const std::array<BiquadCoeffs, Lanes>& c) {
+        Section s{};
+        for (size_t l = 0; l < Lanes; l++) {
+            s.b0[l] = c[l].b0;
+            s.b1[l] = c[l].b1;
+            s.b2[l] = c[l].b2;
+            s.a1[l] = c[l].a1;
+            s.a2[l] = c[l].a2;
+        }
+        sections.push_back(s);
+    }
+
+    void process(std::span<ChannelFrame<Lanes>> io) {
+        // Up to four sections per pass over the block, so their state lives in registers and
+        // consecutive sections overlap instead of waiting on each other's feedback
+        for (size_t first = 0; first < sections.size();) {
+            switch (std::min<size_t>(sections.size() - first, 4)) {
+                case 1: run<1>(io, first); first += 1; break;
+                case 2: run<2>(io, first); first += 2; break;
+                case 3: run<3>(io, first); first += 3; break;
+                default: run<4>(io, first); first += 4; break;
+            }
+        }
+    }
+
+    // Single lane banks filter plain float blocks
+    void process(std::span<float> io) requires(Lanes == 1) {
+        process(std::span<ChannelFrame<1>>(reinterpret_cast<ChannelFrame<1>*>(io.data()), io.size()));
+    }
+
+    size_t size() const { return sections.size(); }
+
+private:
+    struct Section {
+        float b0[Lanes], b1[Lanes], b2[Lanes], a1[Lanes], a2[Lanes];
+        float x1[Lanes], x2[Lanes], y1[Lanes], y2[Lanes];
+    };
+
+    template <size_t S>
+    void run(std::span<ChannelFrame<Lanes>> io, size_t first) {
+        Section sec[S];
+        for (size_t k = 0; k < S; k++) sec[k] = sections[first + k];
+
+        for (ChannelFrame<Lanes>& frame : io) {
+            float v[Lanes];
+            for (size_t l = 0; l < Lanes; l++) v[l] = frame[l];
+
+            // Direct Form I, the output of a section is the input of the next
+            for (size_t k = 0; k < S; k++) {
+                Section& s = sec[k];
+                for (size_t l = 0; l < Lanes; l++) {
+                    const float y = s.b0[l] * v[l] + s.b1[l] * s.x1[l] + s.b2[l] * s.x2[l] - s.a2[l] * s.y2[l] - s.a1[l] * s.y1[l];
+                    s.x2[l] = s.x1[l];
+                    s.x1[l] = v[l];
+                    s.y2[l] = s.y1[l];
+                    s.y1[l] = y;
+                    v[l] = y;
+                }
+            }
+
+            for (size_t l = 0; l < Lanes; l++) frame[l] = v[l];
+        }
+
+        for (size_t k = 0; k < S; k++) sections[first + k] = sec[k];
+    }
+
+    std::vector<Section> sections;
+};
+
+
+/*!
+\brief	Second audio stage: anti-aliasing LPF decimator to the audio rate, 19kHz notch and de-emphasis,
+        then the L/R matrix. One 2-lane filter runs in both modes, mono blocks carry L-R = 0 (as
+        StereoSeparator writes them), so the filter history and decimation phase never go stale when
+        the pilot comes and goes.
+*/
+struct StereoAudioStage {
+    AutoFIRFilter<ChannelFrame<2>> lpf;     // L+R and L-R in one pass over the taps
+    BiquadBank<2> iir;                      // 19kHz notch on L+R, de-emphasis on L+R and L-R
+
+    StereoAudioStage(int decim, std::span<const float> taps, float audio_rate, bool allow_fft = true)
+        : lpf(decim, taps, allow_fft) {
+        // De-emphasis is linear and identical on both lanes, so it runs before the L/R matrix
+        iir.add(std::array<BiquadCoeffs, 2>{NotchFilter19k(audio_rate).coeffs(), BiquadCoeffs{}});
+        iir.add(DeemphasisBiquad(audio_rate, 75e-6f).coeffs());
+    }
 
+    /*!
+    \brief		in[i] = {L+R, L-R} at the MPX rate, out receives L/R at the audio rate
+    \param 		out - needs room for the filter output, (in.size() + block_latency()) / D + 1 frames
+    \return     Number of frames written to out
+    */
+    size_t process(std::span<const ChannelFrame<2>> in, std::span<ChannelFrame<2>> out) {
+        const size_t count = lpf.process(in, out);
+        iir.process(out.first(count));
+        for (size_t j = 0; j < count; j++) {
+            const float mono_out = out[j][0];
+            const float diff_out = out[j][1];
+            out[j] = {mono_out + diff_out, mono_out - diff_out};     // Matrix L+R
+        }
+        return count;
+    }
+
+    bool uses_fft() const { return lpf.uses_fft(); }
+
+    // Extra delay in inputs on top of the filter group delay
+    size_t block_latency() const { return lpf.block_latency(); }
+};
+
+
+// Audio output stage - AGC, volume and soft clip over a block of L/R frames
+struct AudioOutputStage {
+    SimpleAgc agc;      // one envelope shared by L and R, updated L then R as before
+
+    // monitor receives the interleaved AGC output, out the volume scaled and soft clipped samples
+    void process(std::span<const ChannelFrame<2>> in, float volume, std::span<float> monitor, std::span<float> out) {
+        for (size_t i = 0; i < in.size(); i++) {
+            const float left = agc.apply(in[i][0]);
+            const float right = agc.apply(in[i][1]);
+            monitor[2 * i] = left;
+            monitor[2 * i + 1] = right;
+            out[2 * i] = softclip(left * volume);
+            out[2 * i + 1] = softclip(right * volume);
+        }
+    }
+};
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <fftw3.h>
+#include <vector>
+#include <complex>
+#include <span>
+#include <deque>
+#include <memory>
+#include <cmath>
+#include <algorithm>
+#include <type_traits>
+#include "FIRFilter.hpp"
+#include "SimdKernels.hpp"
+
+// Cost model for picking direct or FFT convolution, in real flops per input sample.
+// Radix-2 style FFT estimate of 5 L log2 L flops per complex transform, half that for real data.
+namespace conv_cost {
+
+// Direct form: only decimated outputs are computed, symmetric taps are folded
+inline double direct(size_t taps, int decim, bool complex_samples) {
+    const double macs = (double)((taps + 1) / 2) / decim;
+    return macs * 2.0 * (complex_samples ? 2.0 : 1.0);
+}
+
+// Overlap-save with transform size L: every output in a block is computed, decimation discards the rest
+inline double fft(size_t taps, size_t L, bool complex_samples) {
+    if (L <= taps) return 1e30;
+    const double hop = (double)(L - taps + 1);
+    const double scale = complex_samples ? 1.0 : 0.5;
+    const double bins = complex_samples ? (double)L : (double)(L / 2 + 1);
+    const double transforms = 2.0 * scale * 5.0 * L * std::log2((double)L);
+    return (transforms + 6.0 * bins) / hop;
+}
+
+// Cheapest power of two transform size for a tap count
+inline size_t best_fft_size(size_t taps, bool complex_samples) {
+    size_t best = 0;
+    double best_cost = 1e30;
+    for (size_t L = 64; L <= (size_t)1 << 20; L <<= 1) {
+        const double c = fft(taps, L, complex_samples);
+        if (c < best_cost) { best_cost = c; best = L; }
+    }
+    return best;
+}
+
+// True when overlap-save is estimated to be cheaper than the direct polyphase filter
+inline bool prefer_fft(size_t taps, int decim, bool complex_samples = false) {
+    return fft(taps, best_fft_size(taps, complex_samples), complex_samples) < direct(taps, decim, complex_samples);
+}
+
+}
+
+template <typename T>
+
+/*!
+\brief	Overlap-save FFT convolution filter with decimation, a drop-in for FIRFilter<T> (float or
+        complex<float>). Outputs match FIRFilter sample for sample, but are released one transform
+        block at a time, so the stream is delayed by up to block_size() inputs.
+*/
+class FFTFilter {
+    static_assert(std::is_same_v<T, float> || std::is_same_v<T, std::complex<float>>,
+                  "FFTFilter supports float and complex<float> samples");
+    static constexpr bool is_complex = std::is_same_v<T, std::complex<float>>;
+
+public:
+    FFTFilter(int decim, std::span<const float> taps, size_t fft_size = 0)
+        : N(taps.size()), L(fft_size ? fft_size : conv_cost::best_fft_size(taps.size(), is_complex)),
+          M(L - N + 1), D(decim), bins(is_complex ? L : L / 2 + 1)
+    {
+        x = (T*)fftwf_malloc(sizeof(T) * L);
+        y = (T*)fftwf_malloc(sizeof(T) * L);
+        spec = (fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * bins);
+        std::fill(x, x + L, T{});
+
+        if constexpr (is_complex) {
+            fwd = fftwf_plan_dft_1d((int)L, (fftwf_complex*)x, spec, FFTW_FORWARD, FFTW_MEASURE);
+            inv = fftwf_plan_dft_1d((int)L, spec, (fftwf_complex*)y, FFTW_BACKWARD, FFTW_MEASURE);
+        } else {
+            fwd = fftwf_plan_dft_r2c_1d((int)L, x, spec, FFTW_MEASURE);
+            inv = fftwf_plan_dft_c2r_1d((int)L, spec, y, FFTW_MEASURE);
+        }
+
+        // Taps spectrum, 1/L inverse transform scaling folded in
+        std::fill(x, x + L, T{});
+        for (size_t k = 0; k < N; k++) x[k] = T(taps[k] / (float)L);
+        fftwf_execute(fwd);
+        H.assign(reinterpret_cast<std::complex<float>*>(spec), reinterpret_cast<std::complex<float>*>(spec) + bins);
+
+        std::fill(x, x + L, T{});
+        fill = N - 1;
+    }
+
+    ~FFTFilter() {
+        fftwf_destroy_plan(fwd);
+        fftwf_destroy_plan(inv);
+        fftwf_free(x);
+        fftwf_free(y);
+        fftwf_free(spec);
+    }
+
+    FFTFilter(const FFTFilter&) = delete;
+    FFTFilter& operator=(const FFTFilter&) = delete;
+
+    /*!
+    \brief		Sample by sample interface, returns true if an output sample is ready
+    \param 		input - Current input sample
+    */
+    bool Filter(const T& input, T& output) {
+        push(&input, 1);
+        if (++ctr_in < D) return false;
+        ctr_in = 0;
+        if (pending.empty()) return false;      // first block still filling
+        output = pending.front();
+        pending.pop_front();
+        return true;
+    }
+
+    /*!
+    \brief		Block filtering, outputs are released for every completed transform block
+    \param 		in - Block of input samples
+    \param 		out - Output samples, needs room for (in.size() + block_size()) / D + 1 samples
+    \return     Number of output samples written to out
+    */
+    size_t process(std::span<const T> in, std::span<T> out) {
+        push(in.data(), in.size());
+        const size_t produced = std::min(out.size(), pending.size());
+        std::copy(pending.begin(), pending.begin() + produced, out.begin());
+        pending.erase(pending.begin(), pending.begin() + produced);
+        return produced;
+    }
+
+    // New input samples consumed per transform
+    size_t block_size() const { return M; }
+    size_t fft_size() const { return L; }
+
+private:
+    void push(const T* in, size_t count) {
+        while (count > 0) {
+            const size_t take = std::min(count, L - fill);
+            std::copy(in, in + take, x + fill);
+            fill += take;
+            in += take;
+            count -= take;
+            if (fill == L) run_block();
+        }
+    }
+
+    // One overlap-save block: outputs N-1 .. L-1 of the circular convolution are valid
+    void run_block() {
+        fftwf_execute(fwd);
+        simd::kernels().cmul(reinterpret_cast<const std::complex<float>*>(spec), H.data(),
+                             reinterpret_cast<std::complex<float>*>(spec), bins);
+        fftwf_execute(inv);
+
+        // Decimated outputs keep the same phase as FIRFilter: every D-th input, starting with the D-th
+        size_t n = (size_t)(D - 1 - phase);
+        for (; n < M; n += D) pending.push_back(y[N - 1 + n]);
+        phase = (int)((phase + M) % D);
+
+        // Keep the newest N-1 inputs as history for the next block
+        std::copy(x + L - (N - 1), x + L, x);
+        fill = N - 1;
+    }
+
+    size_t N;                               // number of taps
+    size_t L;                               // transform size
+    size_t M;                               // new inputs per block
+    int D;                                  // decimation factor
+    size_t bins;                            // spectrum length
+    size_t fill;                            // samples in the input window
+    int phase = 0;                          // decimation phase at the start of the next block
+    int ctr_in = 0;                         // decimation counter for Filter()
+    T* x;                                   // input window, N-1 history + M new samples
+    T* y;                                   // circular convolution output
+    fftwf_complex* spec;                    // spectrum scratch
+    std::vector<std::complex<float>> H;     // taps spectrum
+    fftwf_plan fwd, inv;
+    std::deque<T> pending;                  // decimated outputs not yet handed out
+};
+
+template <typename T>
+
+/*!
+\brief	FIR filter that picks direct polyphase or overlap-save FFT convolution with the
+        conv_cost heuristic. Same interface as FIRFilter. ChannelFrame<2> streams run through
+        the complex transform, real taps keep the two lanes independent.
+*/
+class AutoFIRFilter {
+    using FftSample = std::conditional_t<std::is_same_v<T, ChannelFrame<2>>, std::complex<float>, T>;
+    static constexpr bool fft_capable = std::is_same_v<FftSample, float> || std::is_same_v<FftSample, std::complex<float>>;
+    using FftEngine = FFTFilter<std::conditional_t<fft_capable, FftSample, float>>;
+
+public:
+    // allow_fft = false keeps the direct filter, overlap-save holds back up to a transform block
+    AutoFIRFilter(int decim, std::span<const float> taps, bool allow_fft = true)
+        : use_fft(allow_fft && fft_capable && conv_cost::prefer_fft(taps.size(), decim, !std::is_same_v<T, float>)) {
+        if (use_fft) fft = std::make_unique<FftEngine>(decim, taps);
+        else fir = std::make_unique<FIRFilter<T>>(decim, taps);
+    }
+
+    bool Filter(const T& input, T& output) {
+        if constexpr (fft_capable) {
+            if (use_fft) return fft->Filter(reinterpret_cast<const FftSample&>(input), reinterpret_cast<FftSample&>(output));
+        }
+        return fir->Filter(input, output);
+    }
+
+    size_t process(std::span<const T> in, std::span<T> out) {
+        if constexpr (fft_capable) {
+            if (use_fft) {
+                return fft->process(std::span<const FftSample>(reinterpret_cast<const FftSample*>(in.data()), in.size()),
+                                    std::span<FftSample>(reinterpret_cast<FftSample*>(out.data()), out.size()));
+            }
+        }
+        return fir->process(in, out);
+    }
+
+    bool uses_fft() const { return use_fft; }
+
+    // Extra delay in inputs on top of the filter group delay
+    size_t block_latency() const { return use_fft ? fft->block_size() : 0; }
+
+private:
+    bool use_fft;
+    std::unique_ptr<FIRFilter<T>> fir;
+    std::unique_ptr<FftEngine> fft;
+};
@@ -1,15 +1,32 @@
+#pragma once
+
 #include <vector>
 #include <algorithm>
 #include <complex>
+#include <span>
+#include <cmath>
+#include <type_traits>
+#include <array>
+#include <memory>
+#include "SimdKernels.hpp"
+#include "ChannelFrame.hpp"
+#include "CoefficientStore.hpp"
 
 template <typename T>
 
 /*!
 \brief	Class to encapsulate an FIR Filter implementation. 
+        Coefficients live in the shared CoefficientStore, instances built from the same taps share one copy.
 */
 class FIRFilter {
 public:
-    FIRFilter(int decim, const std::vector<float> &taps) : buf_idx(0), D(decim), x(taps.size()), ctr(0), b(taps) {}
+    FIRFilter(int decim, std::span<const float> taps)
+        : FIRFilter(CoefficientStore::acquire(taps), decim) {}
+
+    /*!
+    \brief		True when the taps are linear-phase symmetric and the folded kernel is used
+    */
+    bool folded() const { return symmetric; }
 
     /*!
     \brief		Perform filtering on a sample by sample basis, retrun true if output sample is ready
@@ -17,54 +34,161 @@ public:
     */
     bool Filter(const T& input, T& output) {
 
-        x[buf_idx] = input;   // Store current input value in input buffer
-
-        // Advance buffer index for next sample
-        if (++buf_idx >= (int)b.size()) buf_idx = 0;
+        if (pos == (int)x.size()) compact();    // slide history back to the start of the window
+        x[pos++] = input;                       // Store current input value in input window
 
         ctr++;
-        if (ctr < D) return false;      // decimate samples using counter
+        if (ctr < D) return false;              // decimate samples using counter
         ctr = 0;
 
-        T temp_out{};
+        // Set output to filtered input sample
+        output = dot(x.data() + pos - N);
+
+        return true;
 
-        int cur_idx = buf_idx-1;
-        if (cur_idx < 0) cur_idx = (int)b.size() - 1;
-        int k = 0;
+    }
 
-        // Loop for adding feedforward components starting from current index
-        for (int i = cur_idx; i >= 0; i--) {
-            temp_out += x[i] * b[k];                // b0*x[n] + b1*x[n-1] + ....
-            k++;
-        }
+    /*!
+    \brief		Polyphase block filtering, only the decimated output samples are computed.
+                State is shared with Filter(), so both calls can be mixed on one stream.
+    \param 		in - Block of input samples
+    \param 		out - Output samples, needs room for (in.size() + D - 1) / D samples
+    \return     Number of output samples written to out
+    */
+    size_t process(std::span<const T> in, std::span<T> out) {
+        return process_from(in.size(), [&](T* dst, size_t offset, size_t count) {
+            std::copy(in.begin() + offset, in.begin() + offset + count, dst);
+        }, out);
+    }
+
+    /*!
+    \brief		Block filtering where the input is generated straight into the history window,
+                used by fused front ends to skip an intermediate sample buffer.
+    \param 		count - Number of input samples
+    \param 		load - Callable load(T* dst, size_t offset, size_t n) writing inputs [offset, offset+n)
+    \param 		out - Output samples, needs room for (count + D - 1) / D samples
+    \return     Number of output samples written to out
+    */
+    template <typename Loader>
+    size_t process_from(size_t count, Loader&& load, std::span<T> out) {
+        // Inputs beyond the capacity of out are not consumed
+        count = std::min(count, (size_t)(D - 1 - ctr) + out.size() * D);
+        size_t consumed = 0;
+        size_t produced = 0;
+
+        while (consumed < count) {
+            if (pos == (int)x.size()) compact();
+
+            // Append as much of the block as fits into the window
+            const size_t take = std::min(count - consumed, x.size() - pos);
+            load(x.data() + pos, consumed, take);
 
-        // Loop for adding components from wrap-around index
-        for (int i = (int)b.size()-1; i > cur_idx; i--) {
-            temp_out += x[i] * b[k];                // b_k*x[n-k] + b_k-1*x[n-k-1] + ....
-            k++;
+            // Only evaluate the phases that land on a decimated output
+            size_t n = (size_t)(D - 1 - ctr);
+            for (; n < take; n += D) {
+                out[produced++] = dot(x.data() + pos + n + 1 - N);      // window ending at new sample n
+            }
+
+            ctr = (int)((ctr + take) % D);
+            pos += (int)take;
+            consumed += take;
         }
 
-        // Set output to filtered input sample
-        output = temp_out;  
+        return produced;
+    }
 
-        return true;
+    /*!
+    \brief		Sum of the taps (gain at DC)
+    */
+    float dc_gain() const { return taps->dc_gain(); }
 
+    /*!
+    \brief		Group delay at DC in input samples, (N-1)/2 for linear phase taps
+    */
+    double group_delay() const {
+        double num = 0.0, den = 0.0;
+        for (int j = 0; j < N; j++) {
+            num += (double)(N - 1 - j) * b_rev[j];     // b_rev[j] is h[N-1-j]
+            den += b_rev[j];
+        }
+        return num / den;
+    }
+
+    /*!
+    \brief		Tap multiplies per input sample, accounting for decimation and tap folding
+    */
+    float macs_per_input() const {
+        return (float)(symmetric ? (N + 1) / 2 : N) / (float)D;
     }
 
+    /*!
+    \brief		Shared coefficient storage, equal for every filter built from the same taps
+    */
+    const TapSet& coefficients() const { return *taps; }
+
 private:
-    std::vector<T> x;                       // ring buffer of input samples
-    std::vector<float> b;                   // Filter coefficients
-    int buf_idx;                            // buffer index
-    int D;                                  // decimation factor
-    int ctr;                                // counter for decimation
+    FIRFilter(std::shared_ptr<const TapSet> set, int decim)
+        : taps(std::move(set)), b_rev(taps->data()), D(decim), ctr(0), N((int)taps->size()),
+          x(taps->size() - 1 + std::max<size_t>(4 * taps->size(), 4096)), pos((int)taps->size() - 1),
+          symmetric(taps->is_symmetric()) {}
 
+    // Single contiguous inner product, w points at the oldest sample of the window
+    T dot(const T* w) const {
+        // float and complex<float> streams use the runtime-dispatched SIMD kernels
+        if constexpr (std::is_same_v<T, float>) {
+            return symmetric ? kern->dot_sym_f32(w, b_rev, N) : kern->dot_f32(w, b_rev, N);
+        } else if constexpr (std::is_same_v<T, std::complex<float>>) {
+            return symmetric ? kern->dot_sym_cf32(w, b_rev, N) : kern->dot_cf32(w, b_rev, N);
+        } else if constexpr (std::is_same_v<T, ChannelFrame<2>>) {
+            // Two lanes with real taps are exactly a complex<float> dot product
+            const std::complex<float>* c = reinterpret_cast<const std::complex<float>*>(w);
+            const std::complex<float> r = symmetric ? kern->dot_sym_cf32(c, b_rev, N) : kern->dot_cf32(c, b_rev, N);
+            return ChannelFrame<2>{{r.real(), r.imag()}};
+        }
+
+        T acc{};
+
+        if (symmetric) {
+            // b_k == b_N-1-k: add mirrored samples first, half the multiplies
+            const int half = N / 2;
+            for (int k = 0; k < half; k++) {
+                acc += (w[k] + w[N - 1 - k]) * b_rev[k];
+            }
+            if (N & 1) acc += w[half] * b_rev[half];      // centre tap of odd length filters
+            return acc;
+        }
+
+        for (int k = 0; k < N; k++) {
+            acc += w[k] * b_rev[k];             // b_N-1*x[n-N+1] + ... + b0*x[n]
+        }
+        return acc;
+    }
+
+    // Move the newest N-1 samples back to the front of the window
+    void compact() {
+        std::copy(x.end() - (N - 1), x.end(), x.begin());
+        pos = N - 1;
+    }
 
+    std::shared_ptr<const TapSet> taps;     // shared, cache-aligned filter coefficients
+    const float* b_rev;                     // Filter coefficients in time order (oldest sample first)
+    int D;                                  // decimation factor
+    int ctr;                                // counter for decimation
+    int N;                                  // number of taps
+    std::vector<T> x;                       // sliding window of input samples, N-1 history + free space
+    int pos;                                // write position in the window
+    bool symmetric;                         // use folded kernel for linear-phase taps
+    const simd::KernelTable* kern = &simd::kernels();
 
 };
 
+// FIR over N interleaved channels sharing one set of taps and one history window
+template <size_t Lanes>
+using MultiChannelFIR = FIRFilter<ChannelFrame<Lanes>>;
+
 
 
-inline std::vector<float> radio_taps = {   // 347 coefficients from scipy FIR kaiser window, 70dB atten, 100kHz, 30kHz width, 2.4MHz fs
+alignas(64) inline constexpr std::array<float, 347> radio_taps = {   // 347 coefficients from scipy FIR kaiser window, 70dB atten, 100kHz, 30kHz width, 2.4MHz fs
         1.32177518e-05,  1.35394262e-05,  1.25297958e-05,  9.97355987e-06,
         5.77727428e-06, -4.26043537e-20, -7.12688663e-06, -1.51941444e-05,
        -2.36258352e-05, -3.17083564e-05, -3.86369181e-05, -4.35773397e-05,
@@ -155,7 +279,7 @@ inline std::vector<float> radio_taps = {   // 347 coefficients from scipy FIR ka
 };
 
 
-inline std::vector<float> audio_taps = {   // 563 coefficients from scipy FIR kaiser window, 60db atten, 15kHz fc, 3.1kHz width, 480kHz fs
+alignas(64) inline constexpr std::array<float, 561> audio_taps = {   // 561 coefficients from scipy FIR kaiser window, 60db atten, 15kHz fc, 3.1kHz width, 480kHz fs
         -9.35814263e-06, -9.95063959e-06, -1.01310727e-05, -9.82762557e-06,
        -8.98575717e-06, -7.57309650e-06, -5.58363166e-06, -3.04091079e-06,
        -2.44470897e-20,  3.45201273e-06,  7.19712086e-06,  1.10891931e-05,
@@ -0,0 +1,410 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <complex>
+#include <limits>
+#include <algorithm>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <filesystem>
+
+// Kaiser window FIR design, formulas follow scipy.signal kaiserord / kaiser_beta / firwin
+// so that generated taps line up with the tables in FIRFilter.hpp
+namespace design {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Zeroth order modified Bessel function of the first kind (power series)
+inline double bessel_i0(double x) {
+    double sum = 1.0, term = 1.0;
+    const double q = x * x / 4.0;
+    for (int k = 1; k < 500; k++) {
+        term *= q / ((double)k * k);
+        sum += term;
+        if (term < sum * 1e-17) break;
+    }
+    return sum;
+}
+
+// Kaiser beta for a stopband attenuation in dB
+inline double kaiser_beta(double atten_db) {
+    if (atten_db > 50.0) return 0.1102 * (atten_db - 8.7);
+    if (atten_db > 21.0) return 0.5842 * std::pow(atten_db - 21.0, 0.4) + 0.07886 * (atten_db - 21.0);
+    return 0.0;
+}
+
+// Number of taps for a stopband attenuation in dB and a transition width in Hz
+inline int kaiser_numtaps(double atten_db, double width, double fs) {
+    const double w = width / (0.5 * fs);        // normalized to Nyquist
+    return (int)std::ceil((atten_db - 7.95) / 2.285 / (kPi * w) + 1.0);
+}
+
+inline double kaiser_window(int n, int numtaps, double beta) {
+    if (numtaps == 1) return 1.0;
+    const double r = 2.0 * n / (numtaps - 1) - 1.0;
+    return bessel_i0(beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / bessel_i0(beta);
+}
+
+inline std::vector<float> normalized(const std::vector<double>& h) {
+    double sum = 0.0;
+    for (double t : h) sum += t;
+    std::vector<float> out(h.size());
+    for (size_t n = 0; n < h.size(); n++) out[n] = (float)(h[n] / sum);
+    return out;
+}
+
+// Windowed-sinc lowpass, cutoff in Hz (-6 dB point), scaled to unity gain at DC
+inline std::vector<float> firwin(int numtaps, double cutoff, double beta, double fs) {
+    const double c = cutoff / (0.5 * fs);
+    const double alpha = 0.5 * (numtaps - 1);
+    std::vector<double> h(numtaps);
+    for (int n = 0; n < numtaps; n++) {
+        const double m = n - alpha;
+        const double s = (m == 0.0) ? 1.0 : std::sin(kPi * c * m) / (kPi * c * m);
+        h[n] = c * s * kaiser_window(n, numtaps, beta);
+    }
+    return normalized(h);
+}
+
+// Half-band lowpass for decimation by 2, cutoff fs/4. Length is 4K+3 so the outermost taps
+// are nonzero; every even offset from the centre tap is exactly zero and the centre is 0.5.
+inline std::vector<float> halfband(double atten_db, double transition, double fs) {
+    const int min_taps = kaiser_numtaps(atten_db, transition, fs);
+    const int K = std::max(0, (min_taps - 3 + 3) / 4);
+    const int numtaps = 4 * K + 3;
+    const int centre = numtaps / 2;
+
+    std::vector<float> h = firwin(numtaps, 0.25 * fs, kaiser_beta(atten_db), fs);
+    double side = 0.0;
+    for (int n = 0; n < numtaps; n++) {
+        if (n == centre) continue;
+        if ((n - centre) % 2 == 0) h[n] = 0.0f;
+        else side += h[n];
+    }
+    for (int n = 0; n < numtaps; n++) {
+        if ((n - centre) % 2 != 0) h[n] = (float)(h[n] * 0.5 / side);
+    }
+    h[centre] = 0.5f;
+    return h;
+}
+
+// Magnitude response of an order N, decimate-by-R CIC running at fs_cic
+inline double cic_response(double f, int R, int order, double fs_cic) {
+    const double s = std::sin(kPi * f / fs_cic);
+    if (std::abs(s) < 1e-12) return 1.0;
+    return std::pow(std::abs(std::sin(kPi * f * R / fs_cic) / (R * s)), order);
+}
+
+// Kaiser windowed lowpass whose passband is shaped by 1 / CIC response to flatten the CIC droop.
+// The ideal response is integrated numerically, cutoff and transition behave like firwin().
+inline std::vector<float> cic_compensator(int numtaps, double cutoff, double beta, double fs,
+                                          int R, int order, double fs_cic) {
+    const int steps = 4096;
+    const double df = cutoff / steps;
+    const double alpha = 0.5 * (numtaps - 1);
+
+    std::vector<double> gain(steps);
+    for (int i = 0; i < steps; i++) gain[i] = 1.0 / cic_response((i + 0.5) * df, R, order, fs_cic);
+
+    std::vector<double> h(numtaps);
+    for (int n = 0; n < numtaps; n++) {
+        const double m = n - alpha;
+        double acc = 0.0;
+        for (int i = 0; i < steps; i++) acc += gain[i] * std::cos(2.0 * kPi * (i + 0.5) * df * m / fs);
+        h[n] = 2.0 * acc * df / fs * kaiser_window(n, numtaps, beta);
+    }
+    return normalized(h);
+}
+
+// Elliptic half-band as two parallel all-pass branches, H(z) = (A0(z^2) + z^-1 A1(z^2)) / 2, each
+// branch a cascade of first order sections (a + z^-2) / (1 + a z^-2). Closed form coefficients for
+// the given stopband and transition (Valenzuela / Constantinides), sorted ascending: even indices
+// belong to A0, odd indices to A1. Nonlinear phase, a few samples of delay.
+inline std::vector<double> halfband_allpass(double atten_db, double transition, double fs) {
+    // Selectivity and nome of the elliptic prototype
+    const double tbw = transition / fs;
+    double k = std::tan((1.0 - 2.0 * tbw) * kPi / 4.0);
+    k *= k;
+    const double kk = std::pow(1.0 - k * k, 0.25);
+    const double e = 0.5 * (1.0 - kk) / (1.0 + kk);
+    const double e4 = e * e * e * e;
+    const double q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+
+    // Odd filter order reaching the attenuation
+    const double a2 = std::pow(10.0, -atten_db / 10.0);
+    const double ratio = a2 / (1.0 - a2);
+    int order = (int)std::ceil(std::log(ratio * ratio / 16.0) / std::log(q));
+    order = std::max(3, order | 1);
+
+    std::vector<double> c((order - 1) / 2);
+    for (size_t i = 0; i < c.size(); i++) {
+        const double m = (double)(i + 1);
+        double num = 0.0, den = 0.5, t = 0.0;
+        int n = 0;
+        do {
+            t = std::pow(q, n * (n + 1)) * std::sin((2 * n + 1) * m * kPi / order) * ((n & 1) ? -1.0 : 1.0);
+            num += t;
+            n++;
+        } while (std::abs(t) > 1e-100);
+        n = 1;
+        do {
+            t = std::pow(q, n * n) * std::cos(2 * n * m * kPi / order) * ((n & 1) ? -1.0 : 1.0);
+            den += t;
+            n++;
+        } while (std::abs(t) > 1e-100);
+
+        const double w = num * std::pow(q, 0.25) / den;
+        const double w2 = w * w;
+        const double x = std::sqrt((1.0 - w2 * k) * (1.0 - w2 / k)) / (1.0 + w2);
+        c[i] = (1.0 - x) / (1.0 + x);
+    }
+    return c;
+}
+
+// Magnitude of (z^-2N + z^-1 A(z^2)) / 2 with A(z) = z^-N D(1/z) / D(z), f relative to fs
+inline double halfband_linear_response(const std::vector<double>& d, double f) {
+    const int N = (int)d.size() - 1;
+    const std::complex<double> z1 = std::polar(1.0, -2.0 * kPi * f), z2 = z1 * z1;
+    std::complex<double> num = 0.0, den = 0.0, zk = 1.0;
+    for (int k = 0; k <= N; k++, zk *= z2) {
+        num += d[N - k] * zk;
+        den += d[k] * zk;
+    }
+    return std::abs(0.5 * (std::pow(z2, N) + z1 * num / den));
+}
+
+// Near linear phase half-band: a pure delay of N samples in one branch, an order N all-pass
+// D(z) (d[0] = 1) approximating N - 1/2 samples of delay in the other, both at the low rate.
+// The all-pass phase is fitted by iteratively reweighted least squares over the band that maps
+// onto pass- and stopband; the order grows until the stopband meets atten_db.
+inline std::vector<double> halfband_allpass_linear(double atten_db, double transition, double fs) {
+    const double fp = 0.25 * fs - 0.5 * transition;     // passband edge
+    const double wb = 4.0 * kPi * fp / fs;              // low-rate band the branch delay must match
+    const int grid = 400;
+
+    std::vector<double> d;
+    for (int N = 2; N <= 32; N += 2) {
+        const double tau = N - 0.5;
+        std::vector<double> weight(grid, 1.0);
+        d.assign(N + 1, 0.0);
+        d[0] = 1.0;
+
+        for (int iter = 0; iter < 30; iter++) {
+            // Normal equations of sum_k d_k sin(beta - k w) = 0, beta = (N - tau) w / 2
+            std::vector<std::vector<double>> m(N, std::vector<double>(N + 1, 0.0));
+            for (int g = 0; g < grid; g++) {
+                const double w = wb * (g + 0.5) / grid;
+                const double beta = 0.5 * (N - tau) * w;
+                std::vector<double> r(N + 1);
+                for (int k = 1; k <= N; k++) r[k - 1] = std::sin(beta - k * w);
+                r[N] = -std::sin(beta);
+                for (int i = 0; i < N; i++) {
+                    for (int j = 0; j <= N; j++) m[i][j] += weight[g] * r[i] * r[j];
+                }
+            }
+            for (int i = 0; i < N; i++) {
+                int p = i;
+                for (int r = i + 1; r < N; r++) if (std::abs(m[r][i]) > std::abs(m[p][i])) p = r;
+                std::swap(m[i], m[p]);
+                for (int r = 0; r < N; r++) {
+                    if (r == i) continue;
+                    const double f = m[r][i] / m[i][i];
+                    for (int c = i; c <= N; c++) m[r][c] -= f * m[i][c];
+                }
+            }
+            for (int i = 0; i < N; i++) d[i + 1] = m[i][N] / m[i][i];
+
+            // Reweight towards the largest phase errors, approaching equiripple
+            std::vector<double> err(grid);
+            double peak = 0.0;
+            for (int g = 0; g < grid; g++) {
+                const double w = wb * (g + 0.5) / grid;
+                std::complex<double> D = 0.0;
+                for (int k = 0; k <= N; k++) D += d[k] * std::polar(1.0, -k * w);
+                err[g] = std::abs(std::remainder(-N * w - 2.0 * std::arg(D) + tau * w, 2.0 * kPi));
+                peak = std::max(peak, err[g]);
+            }
+            for (int g = 0; g < grid; g++) weight[g] *= err[g] / peak + 1e-3;
+        }
+
+        double stop = 0.0;
+        for (int g = 0; g <= grid; g++) stop = std::max(stop, halfband_linear_response(d, 0.5 - fp / fs * g / grid));
+        if (20.0 * std::log10(stop) <= -atten_db) break;
+    }
+    return d;
+}
+
+// Lowpass specification in the terms of gen_filter_coeffs.py
+struct KaiserSpec {
+    double fs;              // sample rate
+    double cutoff;          // -6 dB point
+    double transition;      // transition width
+    double atten;           // stopband attenuation / ripple in dB
+};
+
+// scipy kaiserord + firwin equivalent
+inline std::vector<float> kaiser_lowpass(const KaiserSpec& s) {
+    return firwin(kaiser_numtaps(s.atten, s.transition, s.fs), s.cutoff, kaiser_beta(s.atten), s.fs);
+}
+
+// In-place radix-2 FFT for design-time transforms, a.size() a power of two, inverse scaled by 1/n
+inline void fft(std::vector<std::complex<double>>& a, bool inverse) {
+    const size_t n = a.size();
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(a[i], a[j]);
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+        const std::complex<double> w = std::polar(1.0, (inverse ? 2.0 : -2.0) * kPi / len);
+        for (size_t i = 0; i < n; i += len) {
+            std::complex<double> wk = 1.0;
+            for (size_t k = 0; k < len / 2; k++) {
+                const std::complex<double> u = a[i + k], v = a[i + k + len / 2] * wk;
+                a[i + k] = u + v;
+                a[i + k + len / 2] = u - v;
+                wk *= w;
+            }
+        }
+    }
+    if (inverse) {
+        for (std::complex<double>& v : a) v /= (double)n;
+    }
+}
+
+// Minimum phase counterpart of a linear phase FIR, homomorphic method as scipy.signal.minimum_phase:
+// (N+1)/2 taps with the square root of the magnitude response, so the prototype needs twice the
+// attenuation in dB. Most of the energy moves to the first taps, the delay at DC is a few samples.
+inline std::vector<float> minimum_phase(const std::vector<float>& h) {
+    size_t n_fft = 1;
+    while ((double)n_fft < 2.0 * (h.size() - 1) / 0.01) n_fft <<= 1;
+
+    // Real cepstrum of the half log magnitude
+    std::vector<std::complex<double>> a(n_fft);
+    for (size_t n = 0; n < h.size(); n++) a[n] = h[n];
+    fft(a, false);
+    double floor_mag = std::numeric_limits<double>::max();
+    for (const std::complex<double>& v : a) {
+        if (std::abs(v) > 0.0) floor_mag = std::min(floor_mag, std::abs(v));
+    }
+    for (std::complex<double>& v : a) v = 0.5 * std::log(std::abs(v) + 1e-7 * floor_mag);
+    fft(a, true);
+
+    // Fold the anti-causal part onto the causal part, back to the spectrum and exponentiate
+    const size_t stop = (h.size() + 1) / 2;
+    for (size_t n = 0; n < n_fft; n++) {
+        const double w = (n == 0) ? 1.0 : (n < stop) ? 2.0 : (n == stop && (h.size() & 1)) ? 1.0 : 0.0;
+        a[n] = a[n].real() * w;
+    }
+    fft(a, false);
+    for (std::complex<double>& v : a) v = std::exp(v);
+    fft(a, true);
+
+    std::vector<double> out(h.size() / 2 + (h.size() & 1));
+    for (size_t n = 0; n < out.size(); n++) out[n] = a[n].real();
+    return normalized(out);
+}
+
+// Linear phase prototype for a minimum phase design: twice the attenuation in dB, plus 10 dB because
+// the square root also flattens the start of the stopband
+inline KaiserSpec min_phase_prototype(const KaiserSpec& s) {
+    return {s.fs, s.cutoff, s.transition, 2.0 * s.atten + 10.0};
+}
+
+// Minimum phase lowpass meeting the same attenuation as kaiser_lowpass(s)
+inline std::vector<float> kaiser_lowpass_min_phase(const KaiserSpec& s) {
+    return minimum_phase(kaiser_lowpass(min_phase_prototype(s)));
+}
+
+// Group delay at DC in samples, sum n h[n] / sum h[n]; (N-1)/2 for linear phase taps
+inline double group_delay(const std::vector<float>& h) {
+    double num = 0.0, den = 0.0;
+    for (size_t n = 0; n < h.size(); n++) {
+        num += n * (double)h[n];
+        den += h[n];
+    }
+    return num / den;
+}
+
+/*!
+\brief	On-disk cache of designed filters, one text file per parameter set. Designs are cheap but
+        not free (Bessel windows over hundreds of taps), and cached files can be inspected or
+        diffed against the Python reference.
+*/
+class DesignCache {
+public:
+    explicit DesignCache(std::filesystem::path dir = "filter_cache") : root(std::move(dir)) {}
+
+    std::vector<float> lowpass(const KaiserSpec& s, bool min_phase = false) {
+        const KaiserSpec proto = min_phase ? min_phase_prototype(s) : s;
+        const int numtaps = min_phase ? (kaiser_numtaps(proto.atten, s.transition, s.fs) + 1) / 2
+                                      : kaiser_numtaps(s.atten, s.transition, s.fs);
+        const std::filesystem::path file = root / ((min_phase ? "minphase_" : "") + key(s) + ".txt");
+
+        std::vector<float> taps;
+        if (load(file, taps) && (int)taps.size() == numtaps) {
+            hit = true;
+            return taps;
+        }
+
+        hit = false;
+        taps = min_phase ? kaiser_lowpass_min_phase(s) : kaiser_lowpass(s);
+        store(file, s, taps, min_phase);
+        return taps;
+    }
+
+    // True when the last lowpass() call was served from disk
+    bool last_hit() const { return hit; }
+
+    static std::string key(const KaiserSpec& s) {
+        char buf[160];
+        std::snprintf(buf, sizeof(buf), "kaiser_fs%.9g_fc%.9g_tw%.9g_a%.9g", s.fs, s.cutoff, s.transition, s.atten);
+        return buf;
+    }
+
+private:
+    static bool load(const std::filesystem::path& file, std::vector<float>& taps) {
+        std::ifstream in(file);
+        if (!in.is_open()) return false;
+
+        std::string line;
+        while (std::getline(in, line)) {
+            if (line.empty() || line[0] == '#') continue;
+            std::istringstream ss(line);
+            float t;
+            if (!(ss >> t)) return false;
+            taps.push_back(t);
+        }
+        return !taps.empty();
+    }
+
+    // Best effort, a read-only working directory only costs a redesign next time
+    static void store(const std::filesystem::path& file, const KaiserSpec& s, const std::vector<float>& taps, bool min_phase) {
+        std::error_code ec;
+        std::filesystem::create_directories(file.parent_path(), ec);
+
+        const std::filesystem::path tmp = file.string() + ".tmp";
+        {
+            std::ofstream out(tmp);
+            if (!out.is_open()) return;
+            out << (min_phase ? "# minimum phase kaiser lowpass fs=" : "# kaiser lowpass fs=") << s.fs << " cutoff=" << s.cutoff << " transition=" << s.transition
+                << " atten=" << s.atten << " taps=" << taps.size() << "\n";
+            char buf[32];
+            for (float t : taps) {
+                std::snprintf(buf, sizeof(buf), "%.9g\n", t);      // round-trips float exactly
+                out << buf;
+            }
+            if (!out) return;
+        }
+        std::filesystem::rename(tmp, file, ec);
+    }
+
+    std::filesystem::path root;
+    bool hit = false;
+};
+
+}
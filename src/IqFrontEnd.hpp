@@ -0,0 +1,111 @@
+#pragma once
+
+#include <complex>
+#include <cstdint>
+#include <cmath>
+#include <span>
+#include <vector>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include "FIRFilter.hpp"
+#include "MultistageDecimator.hpp"
+#include "SimdKernels.hpp"
+
+/*!
+\brief	Fused RTL-SDR front end: raw uint8 IQ bytes -> DC blocked, decimated complex baseband.
+        Bytes are converted with a vectorized kernel straight into the first-stage FIR history,
+        so no intermediate float block is materialized. The IQ DC offset is tracked once per block
+        and removed after decimation, which is exact because the FIR is linear: filtering (x - dc)
+        equals filter(x) - dc * sum(taps).
+        The first stage is either a single decimating FIR or a CIC + half-band multistage chain.
+*/
+class IqFrontEnd {
+public:
+    IqFrontEnd(int decim, std::span<const float> taps, float dc_alpha = 1.0e-4f)
+        : lpf(std::make_unique<FIRFilter<std::complex<float>>>(decim, taps)),
+          label("FIR " + std::to_string(taps.size()) + " taps /" + std::to_string(decim)),
+          gain(lpf->dc_gain()), alpha(dc_alpha) {}
+
+    explicit IqFrontEnd(const MultistagePlan& plan, float dc_alpha = 1.0e-4f)
+        : chain(std::make_unique<MultistageDecimator>(plan)), label(chain->describe()),
+          gain(1.0f), alpha(dc_alpha) {}
+
+    /*!
+    \brief		Convert and decimate one block of interleaved I/Q bytes
+    \param 		iq - Raw interleaved bytes [I0,Q0,I1,Q1,...]
+    \param 		out - Decimated complex samples, needs room for iq.size() / 2 / decim + 1 samples
+    \param 		tap - Callable tap(const std::complex<float>* x, size_t n) that sees the converted
+                      full-rate samples (DC not yet removed, see dc()), e.g. for the RF visualizer
+    \return     Number of decimated samples written to out
+    */
+    template <typename Tap>
+    size_t process(std::span<const uint8_t> iq, std::span<std::complex<float>> out, Tap&& tap) {
+        const size_t count = iq.size() / 2;
+        if (count == 0) return 0;
+
+        const simd::KernelTable& k = simd::kernels();
+        constexpr bool tapped = !std::is_same_v<std::decay_t<Tap>, std::nullptr_t>;
+        size_t produced = 0;
+
+        if (chain) {
+            // CIC consumes the bytes directly, floats are only needed for the tap
+            if constexpr (tapped) {
+                full.resize(std::max(full.size(), count));
+                k.u8_to_f32(iq.data(), reinterpret_cast<float*>(full.data()), 2 * count, -127.5f, 1.0f / 128.0f);
+                tap(static_cast<const std::complex<float>*>(full.data()), count);
+            }
+            produced = chain->process(iq, out);
+        } else {
+            produced = lpf->process_from(count, [&](std::complex<float>* dst, size_t offset, size_t n) {
+                k.u8_to_f32(iq.data() + 2 * offset, reinterpret_cast<float*>(dst), 2 * n, -127.5f, 1.0f / 128.0f);
+                if constexpr (tapped) tap(static_cast<const std::complex<float>*>(dst), n);
+            }, out);
+        }
+        if (produced == 0) return 0;
+
+        // Block-wise DC tracking on the decimated stream, equivalent to the per-sample
+        // leaky integrator (1 - alpha)^count over the block
+        std::complex<float> mean{};
+        for (size_t i = 0; i < produced; i++) mean += out[i];
+        mean /= (float)produced * gain;
+
+        const float a = 1.0f - std::pow(1.0f - alpha, (float)count);
+        avg += (mean - avg) * a;
+
+        const std::complex<float> offset = avg * gain;
+        for (size_t i = 0; i < produced; i++) out[i] -= offset;
+
+        return produced;
+    }
+
+    size_t process(std::span<const uint8_t> iq, std::span<std::complex<float>> out) {
+        return process(iq, out, nullptr);
+    }
+
+    /*!
+    \brief		Current IQ DC estimate, subtract from tapped samples to match the filtered stream
+    */
+    std::complex<float> dc() const { return avg; }
+
+    /*!
+    \brief		First stage tap multiplies per complex input sample (CIC additions not included)
+    */
+    float macs_per_input() const { return chain ? chain->macs_per_input() : lpf->macs_per_input(); }
+
+    /*!
+    \brief		First stage group delay at DC in input samples
+    */
+    double group_delay() const { return chain ? chain->group_delay() : lpf->group_delay(); }
+
+    const std::string& describe() const { return label; }
+
+private:
+    std::unique_ptr<FIRFilter<std::complex<float>>> lpf;    // single stage decimating LPF
+    std::unique_ptr<MultistageDecimator> chain;             // or CIC + half-band chain
+    std::string label;                                      // first stage layout for logging
+    std::vector<std::complex<float>> full;                  // full-rate samples for the tap (chain only)
+    float gain;                                             // first stage gain at DC
+    float alpha;                                            // DC tracker rate per input sample
+    std::complex<float> avg{0.0f, 0.0f};                    // long-term IQ DC average
+};
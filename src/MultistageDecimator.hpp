@@ -0,0 +1,478 @@
+#pragma once
+
+#include <vector>
+#include <complex>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <memory>
+#include "FIRFilter.hpp"
+#include "FilterDesign.hpp"
+#include "SimdKernels.hpp"
+
+/*!
+\brief	Complex CIC decimator working directly on raw RTL-SDR bytes. Integrators and combs run in
+        wrapping 32-bit integer arithmetic, which is exact as long as the output fits: bytes map to
+        odd values in [-255, 255] and the gain is R^N, so R^N < 2^23 is required. Runs on the
+        dispatched cic_u8 kernel, I and Q of each stage share a vector register.
+*/
+class CicDecimator {
+public:
+    CicDecimator(int decim, int order)
+        : R(decim), N(order), integ(2 * order, 0u), comb(2 * order, 0u) {
+        double gain = 256.0;
+        for (int s = 0; s < N; s++) gain *= R;
+        scale = (float)(1.0 / gain);
+    }
+
+    /*!
+    \brief		Decimate one block of interleaved I/Q bytes
+    \param 		iq - Raw interleaved bytes [I0,Q0,I1,Q1,...]
+    \param 		out - Output samples, needs room for iq.size() / 2 / R + 1 samples
+    \return     Number of output samples written to out
+    */
+    size_t process(std::span<const uint8_t> iq, std::span<std::complex<float>> out) {
+        return simd::kernels().cic_u8(iq.data(), iq.size() / 2, integ.data(), comb.data(), N, R, &ctr, scale, out.data());
+    }
+
+    int decimation() const { return R; }
+    int order() const { return N; }
+
+    // Integer additions per complex input sample, CIC stages need no multiplies
+    float adds_per_input() const { return 2.0f * N * (1.0f + 1.0f / R); }
+
+private:
+    int R;                          // decimation factor
+    int N;                          // number of integrator / comb pairs
+    int ctr = 0;                    // decimation counter
+    float scale;                    // 1 / (256 * R^N), back to the LUT float range
+    std::vector<uint32_t> integ;    // integrator states, [I Q] per stage
+    std::vector<uint32_t> comb;     // comb delay states, [I Q] per stage
+};
+
+/*!
+\brief	Decimate-by-2 half-band filter. Every even offset from the centre tap is zero, so the filter
+        splits into a symmetric FIR over one input phase plus a single centre tap on the other phase.
+        Only the nonzero taps are evaluated.
+*/
+class HalfBandDecimator {
+public:
+    explicit HalfBandDecimator(const std::vector<float>& taps)
+        : K(((int)taps.size() - 3) / 4), centre(taps[taps.size() / 2]),
+          odd(1, even_taps(taps)), qbuf(K) {}
+
+    /*!
+    \brief		Block decimation by 2, odd block lengths are carried over to the next call
+    \param 		in - Input samples
+    \param 		out - Output samples, needs room for in.size() / 2 + 1 samples
+    \return     Number of output samples written to out
+    */
+    size_t process(std::span<const std::complex<float>> in, std::span<std::complex<float>> out) {
+        const size_t pairs = (in.size() + (has_pending ? 1 : 0)) / 2;
+        p.resize(std::max(p.size(), pairs));
+        qbuf.resize(std::max(qbuf.size(), K + pairs));
+
+        // Split into the centre-tap phase (first of each pair) and the FIR phase (second)
+        size_t i = 0, j = 0;
+        if (has_pending && !in.empty()) {
+            qbuf[K] = pending;
+            p[0] = in[0];
+            i = 1;
+            j = 1;
+            has_pending = false;
+        }
+        for (; i + 1 < in.size(); i += 2, j++) {
+            qbuf[K + j] = in[i];
+            p[j] = in[i + 1];
+        }
+        if (i < in.size()) {
+            pending = in[i];
+            has_pending = true;
+        }
+
+        const size_t produced = odd.process(std::span<const std::complex<float>>(p.data(), pairs), out);
+        for (size_t n = 0; n < produced; n++) out[n] += centre * qbuf[n];
+
+        // Keep the last K centre-phase samples as history
+        std::copy(qbuf.begin() + pairs, qbuf.begin() + pairs + K, qbuf.begin());
+        return produced;
+    }
+
+    // Tap multiplies per input sample
+    float macs_per_input() const { return (odd.macs_per_input() + 1.0f) / 2.0f; }
+    int length() const { return 4 * K + 3; }
+
+private:
+    static std::vector<float> even_taps(const std::vector<float>& taps) {
+        std::vector<float> h;
+        for (size_t n = 0; n < taps.size(); n += 2) h.push_back(taps[n]);
+        return h;
+    }
+
+    size_t K;                                   // filter length is 4K+3
+    float centre;                               // centre tap, 0.5 for an ideal half-band
+    FIRFilter<std::complex<float>> odd;         // 2K+2 nonzero taps on the newest phase
+    std::vector<std::complex<float>> p;         // FIR phase scratch
+    std::vector<std::complex<float>> qbuf;      // centre phase, K history + block
+    std::complex<float> pending{};              // unpaired sample from the previous block
+    bool has_pending = false;
+};
+
+/*!
+\brief	Decimate-by-2 half-band built from all-pass branches running at the output rate,
+        y[m] = (A0(x[2m+1]) + A1(x[2m])) / 2. A few multiplies per output replace the tens of taps
+        of HalfBandDecimator at the same stopband.
+        MinimumDelay: both branches are cascades of first order all-pass sections (elliptic design),
+        lowest cost and delay, phase is not linear near the band edge.
+        NearLinear: one branch is a pure delay, the other a direct form all-pass fitted to the same
+        delay, so the phase stays linear to within the stopband ripple at about twice the cost.
+*/
+class IirHalfBandDecimator {
+public:
+    enum class Phase { MinimumDelay, NearLinear };
+
+    /*!
+    \param 		atten_db - Stopband attenuation in dB
+    \param 		transition - Transition width in Hz around fs / 4, the passband ends at fs / 4 - transition / 2
+    \param 		fs - Input sample rate
+    */
+    IirHalfBandDecimator(double atten_db, double transition, double fs, Phase phase = Phase::MinimumDelay)
+        : mode(phase) {
+        if (mode == Phase::MinimumDelay) {
+            const std::vector<double> c = design::halfband_allpass(atten_db, transition, fs);
+            for (size_t i = 0; i < c.size(); i++) (i % 2 == 0 ? branch0 : branch1).push_back({(float)c[i]});
+        }
+        else {
+            const std::vector<double> d = design::halfband_allpass_linear(atten_db, transition, fs);
+            N = (int)d.size() - 1;
+            for (int k = 1; k <= N; k++) den.push_back((float)d[k]);
+            delay.assign(N, {});
+            xh.assign(N + 1, {});
+            yh.assign(N, {});
+        }
+    }
+
+    /*!
+    \brief		Block decimation by 2, odd block lengths are carried over to the next call
+    \param 		in - Input samples
+    \param 		out - Output samples, needs room for in.size() / 2 + 1 samples
+    \return     Number of output samples written to out
+    */
+    size_t process(std::span<const std::complex<float>> in, std::span<std::complex<float>> out) {
+        size_t i = 0, produced = 0;
+        if (has_pending && !in.empty()) {
+            out[produced++] = step(pending, in[0]);
+            i = 1;
+            has_pending = false;
+        }
+
+        // Whole pairs with the filter state held in locals, generic per-pair path for long filters
+        const size_t pairs = (in.size() - i) / 2;
+        const std::complex<float>* x = in.data() + i;
+        std::complex<float>* y = out.data() + produced;
+        if (mode == Phase::MinimumDelay) {
+            switch (branch0.size() + branch1.size()) {
+                case 1: run_min<1, 0>(x, pairs, y); break;
+                case 2: run_min<1, 1>(x, pairs, y); break;
+                case 3: run_min<2, 1>(x, pairs, y); break;
+                case 4: run_min<2, 2>(x, pairs, y); break;
+                case 5: run_min<3, 2>(x, pairs, y); break;
+                case 6: run_min<3, 3>(x, pairs, y); break;
+                case 7: run_min<4, 3>(x, pairs, y); break;
+                case 8: run_min<4, 4>(x, pairs, y); break;
+                default: for (size_t m = 0; m < pairs; m++) y[m] = step(x[2 * m], x[2 * m + 1]);
+            }
+        }
+        else {
+            switch (N) {
+                case 2: run_linear<2>(x, pairs, y); break;
+                case 4: run_linear<4>(x, pairs, y); break;
+                case 6: run_linear<6>(x, pairs, y); break;
+                case 8: run_linear<8>(x, pairs, y); break;
+                case 10: run_linear<10>(x, pairs, y); break;
+                case 12: run_linear<12>(x, pairs, y); break;
+                case 14: run_linear<14>(x, pairs, y); break;
+                case 16: run_linear<16>(x, pairs, y); break;
+                default: for (size_t m = 0; m < pairs; m++) y[m] = step(x[2 * m], x[2 * m + 1]);
+            }
+        }
+        produced += pairs;
+        i += 2 * pairs;
+
+        if (i < in.size()) {
+            pending = in[i];
+            has_pending = true;
+        }
+        return produced;
+    }
+
+    // Coefficient multiplies per input sample, including the final 1/2
+    float macs_per_input() const {
+        return ((mode == Phase::MinimumDelay ? (float)(branch0.size() + branch1.size()) : (float)N) + 1.0f) / 2.0f;
+    }
+
+    // Group delay at DC in input samples
+    double group_delay() const {
+        if (mode == Phase::NearLinear) return 2.0 * N;
+        // (a + z^-2) / (1 + a z^-2) delays 2 (1 - a) / (1 + a) at DC, the branches are averaged
+        double d0 = 0.0, d1 = 1.0;
+        for (const Section& s : branch0) d0 += 2.0 * (1.0 - s.a) / (1.0 + s.a);
+        for (const Section& s : branch1) d1 += 2.0 * (1.0 - s.a) / (1.0 + s.a);
+        return 0.5 * (d0 + d1);
+    }
+
+    std::string describe() const {
+        return mode == Phase::MinimumDelay ? "IIR HB " + std::to_string(branch0.size() + branch1.size()) + " coefs"
+                                           : "IIR-LP HB order " + std::to_string(N);
+    }
+
+private:
+    // First order all-pass a + z^-1 / 1 + a z^-1 at the output rate
+    struct Section {
+        float a;
+        std::complex<float> x1{}, y1{};
+    };
+
+    // One output from the older (even) and newer (odd) input of a pair
+    std::complex<float> step(std::complex<float> even, std::complex<float> odd) {
+        if (mode == Phase::MinimumDelay) {
+            for (Section& s : branch0) {
+                const std::complex<float> y = s.a * (odd - s.y1) + s.x1;
+                s.x1 = odd;
+                s.y1 = y;
+                odd = y;
+            }
+            for (Section& s : branch1) {
+                const std::complex<float> y = s.a * (even - s.y1) + s.x1;
+                s.x1 = even;
+                s.y1 = y;
+                even = y;
+            }
+            return 0.5f * (odd + even);
+        }
+
+        // Delay branch, N samples, newest first
+        const std::complex<float> delayed = delay[N - 1];
+        std::copy_backward(delay.begin(), delay.end() - 1, delay.end());
+        delay[0] = odd;
+
+        // All-pass branch: y[n] = x[n-N] + sum_k d_k (x[n-N+k] - y[n-k]), xh[j] = x[n-j], yh[j] = y[n-1-j]
+        std::copy_backward(xh.begin(), xh.end() - 1, xh.end());
+        xh[0] = even;
+        std::complex<float> y = xh[N];
+        for (int k = 1; k <= N; k++) y += den[k - 1] * (xh[N - k] - yh[k - 1]);
+        std::copy_backward(yh.begin(), yh.end() - 1, yh.end());
+        yh[0] = y;
+        return 0.5f * (delayed + y);
+    }
+
+    // Minimum delay branches with S0 / S1 sections, state in locals: the sections of both branches
+    // overlap instead of waiting on stores to the previous sample's state
+    template <int S0, int S1>
+    void run_min(const std::complex<float>* x, size_t pairs, std::complex<float>* out) {
+        float a0[S0], a1[S1 > 0 ? S1 : 1];
+        std::complex<float> x0[S0], y0[S0], x1[S1 > 0 ? S1 : 1], y1[S1 > 0 ? S1 : 1];
+        for (int s = 0; s < S0; s++) { a0[s] = branch0[s].a; x0[s] = branch0[s].x1; y0[s] = branch0[s].y1; }
+        for (int s = 0; s < S1; s++) { a1[s] = branch1[s].a; x1[s] = branch1[s].x1; y1[s] = branch1[s].y1; }
+
+        for (size_t m = 0; m < pairs; m++) {
+            std::complex<float> e = x[2 * m], o = x[2 * m + 1];
+            for (int s = 0; s < S0; s++) {
+                const std::complex<float> y = a0[s] * (o - y0[s]) + x0[s];
+                x0[s] = o;
+                y0[s] = y;
+                o = y;
+            }
+            for (int s = 0; s < S1; s++) {
+                const std::complex<float> y = a1[s] * (e - y1[s]) + x1[s];
+                x1[s] = e;
+                y1[s] = y;
+                e = y;
+            }
+            out[m] = 0.5f * (o + e);
+        }
+
+        for (int s = 0; s < S0; s++) { branch0[s].x1 = x0[s]; branch0[s].y1 = y0[s]; }
+        for (int s = 0; s < S1; s++) { branch1[s].x1 = x1[s]; branch1[s].y1 = y1[s]; }
+    }
+
+    // Near linear phase branches of order K, histories in locals
+    template <int K>
+    void run_linear(const std::complex<float>* x, size_t pairs, std::complex<float>* out) {
+        float d[K];
+        std::complex<float> dl[K], xs[K + 1], ys[K];
+        std::copy(den.begin(), den.end(), d);
+        std::copy(delay.begin(), delay.end(), dl);
+        std::copy(xh.begin(), xh.end(), xs);
+        std::copy(yh.begin(), yh.end(), ys);
+
+        for (size_t m = 0; m < pairs; m++) {
+            const std::complex<float> delayed = dl[K - 1];
+            for (int k = K - 1; k > 0; k--) dl[k] = dl[k - 1];
+            dl[0] = x[2 * m + 1];
+
+            for (int k = K; k > 0; k--) xs[k] = xs[k - 1];
+            xs[0] = x[2 * m];
+            std::complex<float> acc = xs[K];
+            for (int k = 2; k <= K; k++) acc += d[k - 1] * (xs[K - k] - ys[k - 1]);
+            const std::complex<float> y = acc + d[0] * (xs[K - 1] - ys[0]);     // y[n-1] term last, short recursion
+            for (int k = K - 1; k > 0; k--) ys[k] = ys[k - 1];
+            ys[0] = y;
+            out[m] = 0.5f * (delayed + y);
+        }
+
+        std::copy(dl, dl + K, delay.begin());
+        std::copy(xs, xs + K + 1, xh.begin());
+        std::copy(ys, ys + K, yh.begin());
+    }
+
+    Phase mode;
+    std::vector<Section> branch0, branch1;      // minimum delay branches, newer / older input phase
+    int N = 0;                                  // near linear all-pass order and branch delay
+    std::vector<float> den;                     // d_1..d_N
+    std::vector<std::complex<float>> delay;     // N sample delay line of the newer phase, newest first
+    std::vector<std::complex<float>> xh, yh;    // all-pass input / output history, newest first
+    std::complex<float> pending{};              // unpaired sample from the previous block
+    bool has_pending = false;
+};
+
+/*!
+\brief	Layout of a multistage first stage: CIC -> half-bands -> CIC compensating FIR
+*/
+struct MultistagePlan {
+    enum class HalfBand { Fir, IirMinimumDelay, IirNearLinear };
+
+    int cic_decim = 5;          // CIC decimation factor
+    int cic_order = 5;          // CIC integrator / comb pairs
+    int halfbands = 0;          // number of decimate-by-2 half-band stages
+    int fir_decim = 1;          // decimation of the final compensating FIR
+    double fs = 2.4e6;          // input sample rate
+    double cutoff = 100e3;      // final lowpass cutoff (-6 dB), same spec as radio_taps
+    double transition = 30e3;   // final transition width
+    double atten = 70.0;        // stopband attenuation in dB
+    HalfBand halfband = HalfBand::Fir;      // half-band stage implementation
+
+    // CIC takes the odd part of the ratio (or at least 2), the remaining factors of 2 go to half-bands
+    static MultistagePlan for_decimation(int decim, double fs) {
+        MultistagePlan plan;
+        plan.fs = fs;
+        plan.cic_decim = decim;
+        plan.halfbands = 0;
+        while (plan.cic_decim % 2 == 0 && plan.cic_decim > 2) {
+            plan.cic_decim /= 2;
+            plan.halfbands++;
+        }
+        return plan;
+    }
+
+    int decimation() const { return cic_decim * (1 << halfbands) * fir_decim; }
+};
+
+/*!
+\brief	Multistage replacement for the single radio_taps FIR: a multiplier-free CIC does the bulk of
+        the rate change, half-bands halve the rate at half the cost of a regular FIR, and a short
+        FIR at the lowest rate sets the final band edge and flattens the CIC passband droop.
+        Overall DC gain is 1, matching the LUT + radio_taps path.
+*/
+class MultistageDecimator {
+public:
+    explicit MultistageDecimator(const MultistagePlan& p)
+        : plan(p), cic(p.cic_decim, p.cic_order), comp(p.fir_decim, compensator_taps(p)) {
+        double rate = plan.fs / plan.cic_decim;
+        for (int s = 0; s < plan.halfbands; s++) {
+            // Protect up to the cutoff, aliases may only land above it
+            const double transition = rate / 2 - 2 * plan.cutoff;
+            if (plan.halfband == MultistagePlan::HalfBand::Fir) {
+                halfbands.emplace_back(design::halfband(plan.atten, transition, rate));
+            }
+            else {
+                iir_halfbands.emplace_back(plan.atten, transition, rate,
+                                           plan.halfband == MultistagePlan::HalfBand::IirNearLinear
+                                               ? IirHalfBandDecimator::Phase::NearLinear
+                                               : IirHalfBandDecimator::Phase::MinimumDelay);
+            }
+            rate /= 2;
+        }
+    }
+
+    /*!
+    \brief		Decimate one block of interleaved I/Q bytes
+    \param 		iq - Raw interleaved bytes [I0,Q0,I1,Q1,...]
+    \param 		out - Output samples, needs room for iq.size() / 2 / decimation() + 1 samples
+    \return     Number of output samples written to out
+    */
+    size_t process(std::span<const uint8_t> iq, std::span<std::complex<float>> out) {
+        a.resize(std::max(a.size(), iq.size() / 2 / plan.cic_decim + 1));
+        b.resize(a.size());
+
+        size_t n = cic.process(iq, a);
+        for (HalfBandDecimator& hb : halfbands) {
+            n = hb.process(std::span<const std::complex<float>>(a.data(), n), b);
+            std::swap(a, b);
+        }
+        for (IirHalfBandDecimator& hb : iir_halfbands) {
+            n = hb.process(std::span<const std::complex<float>>(a.data(), n), b);
+            std::swap(a, b);
+        }
+        return comp.process(std::span<const std::complex<float>>(a.data(), n), out);
+    }
+
+    int decimation() const { return plan.decimation(); }
+
+    // Tap multiplies per complex input sample over all stages
+    float macs_per_input() const {
+        float rate = 1.0f / plan.cic_decim;
+        float macs = 0.0f;
+        for (const HalfBandDecimator& hb : halfbands) {
+            macs += hb.macs_per_input() * rate;
+            rate /= 2.0f;
+        }
+        for (const IirHalfBandDecimator& hb : iir_halfbands) {
+            macs += hb.macs_per_input() * rate;
+            rate /= 2.0f;
+        }
+        return macs + comp.macs_per_input() * rate;
+    }
+
+    float adds_per_input() const { return cic.adds_per_input(); }
+
+    // Group delay in input samples: CIC order (R-1)/2, then the linear phase stages at their rates
+    double group_delay() const {
+        double delay = plan.cic_order * (plan.cic_decim - 1) / 2.0;
+        double step = plan.cic_decim;
+        for (const HalfBandDecimator& hb : halfbands) {
+            delay += (hb.length() - 1) / 2.0 * step;
+            step *= 2.0;
+        }
+        for (const IirHalfBandDecimator& hb : iir_halfbands) {
+            delay += hb.group_delay() * step;
+            step *= 2.0;
+        }
+        return delay + (comp_taps - 1) / 2.0 * step;
+    }
+
+    std::string describe() const {
+        std::string s = "CIC R=" + std::to_string(plan.cic_decim) + " N=" + std::to_string(plan.cic_order);
+        for (const HalfBandDecimator& hb : halfbands) s += " -> HB " + std::to_string(hb.length()) + " taps";
+        for (const IirHalfBandDecimator& hb : iir_halfbands) s += " -> " + hb.describe();
+        s += " -> FIR " + std::to_string(comp_taps) + " taps /" + std::to_string(plan.fir_decim);
+        return s;
+    }
+
+private:
+    std::vector<float> compensator_taps(const MultistagePlan& p) {
+        const double rate = p.fs / (p.cic_decim * (1 << p.halfbands));
+        const int numtaps = design::kaiser_numtaps(p.atten, p.transition, rate) | 1;     // odd, linear phase
+        comp_taps = numtaps;
+        return design::cic_compensator(numtaps, p.cutoff, design::kaiser_beta(p.atten), rate,
+                                       p.cic_decim, p.cic_order, p.fs);
+    }
+
+    MultistagePlan plan;
+    int comp_taps = 0;
+    CicDecimator cic;
+    std::vector<HalfBandDecimator> halfbands;
+    std::vector<IirHalfBandDecimator> iir_halfbands;    // used instead of halfbands for the IIR plans
+    FIRFilter<std::complex<float>> comp;        // CIC compensating FIR at the lowest rate
+    std::vector<std::complex<float>> a, b;      // inter-stage scratch
+};
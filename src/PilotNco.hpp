@@ -0,0 +1,179 @@
+#pragma once
+
+#include <complex>
+#include <cmath>
+#include <span>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+// Pilot derived carriers for one MPX sample, e^{j k phase} for k = 1, 2, 3
+struct PilotCarriers {
+    std::complex<float> c19;
+    std::complex<float> c38;
+    std::complex<float> c57;
+};
+
+/*!
+\brief	19kHz pilot PLL whose oscillator is a unit phasor rotated by complex multiplication instead
+        of a phase accumulator fed to sin(). The loop (x * sin(phase) error, proportional + integral
+        update) is the one StereoSeparator always ran. The rotator for the frequency estimate is
+        rebuilt, and the phasor renormalized, every kRetune samples; in between the small per-sample
+        corrections are applied with a second order rotation, so steady state costs no transcendentals.
+*/
+struct PilotNco {
+    static constexpr int kRetune = 256;     // samples between rotator rebuilds / renormalization
+
+    float alpha = 0.01f;    // Loop gain
+    float beta = 0.0001f;   // Integrator gain
+    float freq = 19000.0f;  // Estimated pilot freq
+    float sampleRate;
+
+    std::complex<float> p{1.0f, 0.0f};      // e^{j phase}
+    std::complex<float> rot{1.0f, 0.0f};    // e^{j 2pi rot_freq / fs}
+    float rot_freq = 0.0f;                  // frequency rot was built for
+    float w_per_hz;                         // radians per sample per Hz
+    int until_retune = 0;
+    bool hold = false;                      // open loop: keep rotating at freq, no tracking (no pilot present)
+
+    explicit PilotNco(float fs) : sampleRate(fs), w_per_hz(2.0f * 3.141592654f / fs) {}
+
+    // Advance by one MPX sample, returns e^{j phase} after the loop update
+    std::complex<float> step(float x) {
+        if (--until_retune < 0) retune();
+
+        // PLL - Update Phase
+        p = mul(p, rot);
+        if (hold) return p;
+
+        // PLL - Calculate Error
+        const float pll_error = x * p.imag();
+
+        // Frequency drift since the rotator was built plus the phase correction
+        const float d = w_per_hz * (freq - rot_freq) + alpha * pll_error;
+        freq += beta * pll_error;
+        p = mul(p, {1.0f - 0.5f * d * d, d});
+
+        return p;
+    }
+
+    // Track a block of MPX, out[i] receives the carriers for in[i]
+    void process(std::span<const float> in, std::span<PilotCarriers> out) {
+        for (size_t i = 0; i < in.size(); i++) {
+            const std::complex<float> c19 = step(in[i]);
+            const std::complex<float> c38 = mul(c19, c19);
+            out[i] = {c19, c38, mul(c38, c19)};
+        }
+    }
+
+    // Restart the loop at a measured pilot frequency and phase, e.g. from PilotAcquirer
+    void seed(float freq_hz, float phase) {
+        freq = freq_hz;
+        p = std::polar(1.0f, phase);
+        until_retune = 0;   // rebuild the rotator for the new frequency on the next step
+    }
+
+    // Current phase in radians, (-pi, pi]
+    float phase() const { return std::arg(p); }
+
+    // Plain complex product, std::complex operator* adds inf / nan recovery that costs more than the math
+    static std::complex<float> mul(std::complex<float> a, std::complex<float> b) {
+        return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+    }
+
+private:
+    void retune() {
+        until_retune = kRetune - 1;
+        rot_freq = freq;
+        rot = std::polar(1.0f, w_per_hz * rot_freq);
+        p *= 1.5f - 0.5f * std::norm(p);    // one Newton step towards |p| = 1
+    }
+};
+
+
+/*!
+\brief	Pilot frequency and phase estimate for seeding PilotNco after a retune. Each window of MPX is
+        correlated against the nominal 19kHz in two Hann weighted halves (one DFT bin each). The phase
+        advance from the first half to the second gives the frequency offset, the halves give the
+        phase. The estimate is carried forward sample by sample, so the loop can be seeded whenever
+        the pilot detector confirms the pilot.
+*/
+struct PilotAcquirer {
+    static constexpr double kPilotHz = 19000.0;
+    static constexpr double kMaxOffsetHz = 50.0;    // larger offsets are not a pilot, half the unambiguous range at 10ms
+
+    double freq = kPilotHz;     // estimated pilot frequency, Hz
+    float amplitude = 0.0f;     // estimated pilot amplitude
+    bool valid = false;         // an estimate was taken since reset()
+
+    /*!
+    \param 		fs - MPX sample rate
+    \param 		window - Samples per estimate, split into two halves
+    */
+    PilotAcquirer(float fs, int window) : sampleRate(fs), half(std::max(2, window / 2)), ref(half) {
+        const double w0 = 2.0 * 3.14159265358979 * kPilotHz / fs;
+        double wsum = 0.0;
+        for (int k = 0; k < half; k++) {
+            const double w = std::pow(std::sin(3.14159265358979 * (k + 0.5) / half), 2.0);     // Hann, centred on (half - 1) / 2
+            ref[k] = std::polar((float)w, (float)(-w0 * k));
+            wsum += w;
+        }
+        gain = (float)(2.0 / wsum);
+    }
+
+    // Drop the running window and the estimate
+    void reset() {
+        sum = first = {};
+        k = 0;
+        second = false;
+        valid = false;
+        since = 0;
+    }
+
+    void push(float x) {
+        sum += ref[k] * x;
+        since++;
+        if (++k < half) return;
+        k = 0;
+        if (second) estimate();
+        else first = sum;
+        second = !second;
+        sum = {};
+    }
+
+    // Pilot phase at the last pushed sample, x = amplitude * cos(phase)
+    double phase() const {
+        return std::remainder(end_phase + 2.0 * 3.14159265358979 * freq / sampleRate * since, 2.0 * 3.14159265358979);
+    }
+
+private:
+    void estimate() {
+        const double two_pi = 2.0 * 3.14159265358979;
+        const double w0 = two_pi * kPilotHz / sampleRate;
+
+        // Second half was correlated from its own start, refer it to the window start
+        const std::complex<double> x1 = first;
+        const std::complex<double> x2 = std::complex<double>(sum) * std::polar(1.0, -w0 * half);
+        const double dw = std::arg(x2 * std::conj(x1)) / half;      // offset from 19kHz, radians per sample
+        if (std::abs(dw) / two_pi * sampleRate > kMaxOffsetHz) return;
+
+        // x[n] = A cos((w0 + dw) n + psi0), half one measures psi0 + dw * centre
+        const double centre = 0.5 * (half - 1);
+        const double psi0 = std::arg(x1) - dw * centre;
+        freq = (w0 + dw) / two_pi * sampleRate;
+        end_phase = std::remainder(psi0 + (w0 + dw) * (2 * half - 1), two_pi);
+        amplitude = 0.5f * gain * (float)(std::abs(x1) + std::abs(x2));
+        since = 0;
+        valid = true;
+    }
+
+    float sampleRate;
+    int half;                                   // samples per half window
+    std::vector<std::complex<float>> ref;       // Hann * e^{-j w0 k}
+    float gain;                                 // amplitude from a bin magnitude
+    std::complex<float> sum{}, first{};
+    int k = 0;
+    bool second = false;                        // accumulating the second half
+    double end_phase = 0.0;                     // phase at the last sample of the estimated window
+    int64_t since = 0;                          // samples pushed after that
+};
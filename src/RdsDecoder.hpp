@@ -2,96 +2,184 @@
 
 #include <algorithm>
 #include <array>
-#include <atomic>
 #include <complex>
 #include <cstdint>
 #include <cstdio>
 #include <cmath>
-#include <mutex>
-#include <string>
+#include <cstring>
+#include <span>
+#include <string_view>
 #include <vector>
 
+#include "PilotNco.hpp"
+#include "FIRFilter.hpp"
+#include "FilterDesign.hpp"
+#include "SimdKernels.hpp"
+#include "SeqlockBuffer.hpp"
+
+// NUL terminated text of up to N characters, fixed size so a snapshot copies as plain bytes
+template <size_t N>
+struct RdsText {
+    char chars[N + 1]{};
+
+    const char* c_str() const { return chars; }
+    bool empty() const { return chars[0] == '\0'; }
+    std::string_view view() const { return chars; }
+
+    friend bool operator==(const RdsText&, const RdsText&) = default;
+    friend bool operator==(const RdsText& a, std::string_view b) { return a.view() == b; }
+};
+
+// Immutable decoder state published to other threads, see RdsDecoder::snapshot()
 struct RdsSnapshot {
+    uint64_t version = 0;           // publish count, unchanged version means unchanged contents
     bool synced = false;
-    std::string pi;
-    std::string program_service;
-    std::string radio_text;
+    RdsText<4> pi;                  // hex PI code, empty until one is decoded
+    RdsText<8> program_service;     // trailing spaces trimmed
+    RdsText<64> radio_text;
     uint64_t groups = 0;
     uint64_t blocks = 0;
+    uint64_t corrected_blocks = 0;  // blocks accepted after burst error correction, best path
+
+    // Stereo decoder state, reported alongside RDS
+    bool stereo = false;
+    float pilot_db = 0.0f;          // pilot to guard band ratio
+    float mono_saving = -1.0f;      // share of the stereo path cost saved in mono, < 0 until measured
+
+    bool timing_bank = false;       // 16 phase clock bank running, forced or as weak signal fallback
 };
 
+/*!
+\brief	RDS decoder. The 57kHz subcarrier is mixed to complex baseband with the pilot derived carrier
+        and decimated to about 19kS/s by two FIR stages (alias protection, then the +-2.4kHz channel
+        filter), so chip timing and bit recovery run at 8 samples per chip instead of the MPX rate.
+        Chip timing comes from one Gardner clock with four chip offset / polarity paths, the path that
+        decodes groups is kept and the others dropped until it loses sync. The brute force bank of 16
+        clock phases x 4 paths remains, forced or switched in while the single clock decodes nothing.
+        Decoded state is only touched by the DSP thread and published as a fixed-size RdsSnapshot
+        through a seqlock whenever it changes, so readers never take a lock the DSP thread waits on.
+*/
 class RdsDecoder {
 public:
-    explicit RdsDecoder(float sampleRate)
-        : chip_samples_(sampleRate / 2375.0f),
-          rds_bandpass_(sampleRate, 57000.0f, 4.0f) {
+    static constexpr float kChipRate = 2375.0f;            // biphase chips per second, 2 per bit
+    static constexpr float kBasebandRate = 19000.0f;       // lowest decimated rate, about 8 samples per chip
+    static constexpr double kChannelPass = 2400.0;         // RDS spectrum edge
+    static constexpr double kChannelStop = 4000.0;         // 53kHz L-R band edge relative to 57kHz
+    static constexpr float kGardnerKp = 0.02f;             // timing correction in chips per unit of normalized error
+    static constexpr float kGardnerKi = 2e-4f;             // chip rate correction per unit of normalized error
+    static constexpr int kSyncLossBits = 10 * 26;          // bits without block sync before the resolver searches again
+    static constexpr float kFallbackSeconds = 1.0f;        // Auto: time without a group on the single clock before the bank joins
+
+    enum class Timing {
+        Bank,       // 16 clock phases x 2 chip offsets x 2 polarities
+        Gardner,    // single interpolating clock, 4 paths resolved by syndrome hits
+        Auto        // Gardner, the bank joins while the single clock decodes no blocks
+    };
+
+    explicit RdsDecoder(float sampleRate, Timing timing = Timing::Auto)
+        : timing_(timing),
+          decim_(std::max(1, static_cast<int>(sampleRate / kBasebandRate))),
+          baseband_rate_(sampleRate / static_cast<float>(decim_)),
+          chip_samples_(baseband_rate_ / kChipRate),
+          mix_lpf_(firstStageDecimation(decim_), mixTaps(sampleRate, firstStageDecimation(decim_))),
+          channel_lpf_(decim_ / firstStageDecimation(decim_), channelTaps(sampleRate / firstStageDecimation(decim_))) {
         program_service_.fill(' ');
         radio_text_.fill(' ');
 
+        // Bank: 16 clock phases spread over one chip
         constexpr int phase_count = 16;
-        paths_.reserve(phase_count * 2 * 2);
-
+        clock_countdown_.resize(phase_count);
+        clock_acc_re_.assign(phase_count, 0.0f);
+        clock_acc_im_.assign(phase_count, 0.0f);
         for (int phase = 0; phase < phase_count; ++phase) {
-            ChipClock clock;
-            clock.countdown = (chip_samples_ * static_cast<float>(phase + 1)) / static_cast<float>(phase_count);
-            clocks_.push_back(clock);
-
-            for (int chip_offset = 0; chip_offset < 2; ++chip_offset) {
-                for (int inverted = 0; inverted < 2; ++inverted) {
-                    RdsPath path;
-                    path.clock_index = phase;
-                    path.chip_offset = chip_offset;
-                    path.inverted = inverted != 0;
-                    paths_.push_back(path);
-                }
-            }
+            clock_countdown_[phase] = (chip_samples_ * static_cast<float>(phase + 1)) / static_cast<float>(phase_count);
         }
+        bank_.resize(phase_count, false);
+
+        // Single clock: strobes every half chip, the chip matched filter sums the last chip of samples
+        box_len_ = std::clamp(static_cast<int>(std::lround(chip_samples_)), 1, static_cast<int>(box_hist_.size()));
+        gardner_.countdown = 0.5f * chip_samples_;
+        gardner_bank_.resize(1, true);
+        bit_bank_.resize(1, false);
+        fallback_samples_ = static_cast<int64_t>(kFallbackSeconds * baseband_rate_);
+        group_samples_ = static_cast<int64_t>(104.0f / 1187.5f * baseband_rate_);
+        publishIfChanged();
     }
 
-    void process(float mpx, float pilotPhase) {
-        constexpr float gain = 8.0f;
-        mpx = rds_bandpass_.push(mpx);
-        std::complex<float> rds_lo(std::cos(-3.0f * pilotPhase), std::sin(-3.0f * pilotPhase));
-        std::complex<float> mixed = rds_lo * (mpx * gain);
-
-        for (size_t i = 0; i < clocks_.size(); ++i) {
-            ChipClock& clock = clocks_[i];
-            clock.accum += mixed;
-            clock.samples++;
-            clock.countdown -= 1.0f;
-
-            if (clock.countdown > 0.0f) {
-                continue;
+    // carriers[i] is the pilot NCO output for mpx[i], RDS is mixed down with conj(c57)
+    void process(std::span<const float> mpx, std::span<const PilotCarriers> carriers) {
+        // Mix straight into the first decimator's window, no MPX rate buffer
+        mix_buf_.resize(mpx.size() / firstStageDecimation(decim_) + 1);
+        const size_t n1 = mix_lpf_.process_from(mpx.size(), [&](std::complex<float>* dst, size_t offset, size_t count) {
+            for (size_t k = 0; k < count; ++k) {
+                const std::complex<float> c57 = carriers[offset + k].c57;
+                const float x = mpx[offset + k];
+                dst[k] = {c57.real() * x, -c57.imag() * x};
             }
+        }, mix_buf_);
 
-            std::complex<float> chip{};
-            if (clock.samples > 0) {
-                chip = clock.accum / static_cast<float>(clock.samples);
-            }
+        baseband_buf_.resize(n1 / (decim_ / firstStageDecimation(decim_)) + 1);
+        const size_t n2 = channel_lpf_.process(std::span<const std::complex<float>>(mix_buf_.data(), n1), baseband_buf_);
+        processBaseband(std::span<const std::complex<float>>(baseband_buf_.data(), n2));
+        publishIfChanged();
+    }
 
-            clock.accum = {};
-            clock.samples = 0;
-            clock.countdown += chip_samples_;
+    // rdsLo is the 57kHz local oscillator e^{-j 3 pilot phase}
+    void process(float mpx, std::complex<float> rdsLo) {
+        std::complex<float> mixed;
+        if (!mix_lpf_.Filter(rdsLo * mpx, mixed)) {
+            return;
+        }
+        std::complex<float> baseband;
+        if (channel_lpf_.Filter(mixed, baseband)) {
+            processBaseband(std::span<const std::complex<float>>(&baseband, 1));
+            publishIfChanged();
+        }
+    }
 
-            for (RdsPath& path : paths_) {
-                if (path.clock_index == static_cast<int>(i)) {
-                    processChip(path, chip);
-                }
-            }
+    // Demodulated bits straight into a block parser of their own, e.g. bits recovered elsewhere.
+    // Each bit advances the baseband sample count by two chips so groups are counted as usual
+    void processBits(std::span<const uint8_t> bits) {
+        const int64_t bit_samples = std::lround(2.0f * chip_samples_);
+        for (uint8_t bit : bits) {
+            baseband_samples_ += bit_samples;
+            now_ = baseband_samples_;
+            pushBit(bit_bank_, 0, bit != 0);
         }
+        publishIfChanged();
+    }
+
+    // Decimated baseband rate the chip clocks run at
+    float basebandRate() const { return baseband_rate_; }
+
+    void setTiming(Timing timing) { timing_ = timing; }
+    Timing timing() const { return timing_; }
+
+    // Time the 16 phase bank has run, in seconds of input
+    double bankSeconds() const { return bank_samples_ / static_cast<double>(baseband_rate_); }
+
+    // True while the 16 phase bank runs
+    bool bankActive() const {
+        return timing_ == Timing::Bank ||
+               (timing_ == Timing::Auto && baseband_samples_ - gardner_group_sample_ > fallback_samples_);
     }
 
-    RdsSnapshot snapshot() const {
-        std::lock_guard<std::mutex> lock(mtx_);
-
-        RdsSnapshot snap;
-        snap.synced = synced_.load(std::memory_order_relaxed);
-        snap.pi = pi_;
-        snap.program_service = trimCopy(program_service_);
-        snap.radio_text = trimCopy(radio_text_);
-        snap.groups = groups_;
-        snap.blocks = blocks_;
-        return snap;
+    // Latest published state, any thread. Never blocks the DSP thread, a reader racing a publish retries
+    RdsSnapshot snapshot() const { return published_.read(); }
+
+    // Version of the latest snapshot, readers holding it can skip the copy
+    uint64_t version() const { return published_.version(); }
+
+    // Published with the RDS state when it changes at display resolution (0.1dB, 1% saving)
+    void setStereoStatus(bool stereo, float pilotDb, float monoSaving) {
+        if (stereo != image_.stereo || std::abs(pilotDb - image_.pilot_db) >= 0.05f ||
+            std::abs(monoSaving - image_.mono_saving) >= 0.005f) {
+            image_.stereo = stereo;
+            image_.pilot_db = pilotDb;
+            image_.mono_saving = monoSaving;
+            dirty_ = true;
+        }
+        publishIfChanged();
     }
 
 private:
@@ -104,50 +192,20 @@ private:
         Unknown
     };
 
-    struct ChipClock {
-        float countdown = 0.0f;
-        int samples = 0;
-        std::complex<float> accum{};
-    };
-
-    struct BiquadBandpass {
-        float b0 = 0.0f;
-        float b1 = 0.0f;
-        float b2 = 0.0f;
-        float a1 = 0.0f;
-        float a2 = 0.0f;
-        float x1 = 0.0f;
-        float x2 = 0.0f;
-        float y1 = 0.0f;
-        float y2 = 0.0f;
-
-        BiquadBandpass(float sampleRate, float centerHz, float q) {
-            const float pi = 3.14159265358979323846f;
-            const float w0 = 2.0f * pi * centerHz / sampleRate;
-            const float alpha = std::sin(w0) / (2.0f * q);
-            const float c = std::cos(w0);
-            const float a0 = 1.0f + alpha;
-
-            b0 = alpha / a0;
-            b1 = 0.0f;
-            b2 = -alpha / a0;
-            a1 = -2.0f * c / a0;
-            a2 = (1.0f - alpha) / a0;
-        }
-
-        float push(float x) {
-            const float y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
-            x2 = x1;
-            x1 = x;
-            y2 = y1;
-            y1 = y;
-            return y;
-        }
+    struct GardnerClock {
+        float countdown = 0.0f;         // baseband samples to the next strobe
+        bool on_time = false;           // next strobe ends a chip, otherwise it is the chip middle
+        std::complex<float> box{};      // chip matched filter at the current sample
+        std::complex<float> prev_box{}; // and one sample earlier
+        std::complex<float> mid{};      // last middle strobe
+        std::complex<float> last{};     // last chip
+        float power = 0.0f;             // smoothed chip power, normalizes the timing error
+        float rate = 0.0f;              // chip rate correction, chips per chip
     };
 
     struct BlockParser {
-        uint32_t shift = 0;
-        int bit_count = 0;
+        int since_block = 1 << 30;      // bits since the last valid block, none yet
+        int since_sync = 1 << 30;       // bits since the last block 26 bits after a valid one
         int expected = 0;
         std::array<uint16_t, 4> data{};
         bool third_is_cp = false;
@@ -156,71 +214,226 @@ private:
     };
 
     struct RdsPath {
-        int clock_index = 0;
-        int chip_offset = 0;
-        bool inverted = false;
-        int chip_index = 0;
-        std::complex<float> chip_pair[2]{};
-        bool have_prev_symbol = false;
-        std::complex<float> prev_symbol{};
+        int clock_index = 0;            // -1 on the single clock
         BlockParser parser;
         uint16_t pi = 0;
         int pi_confidence = 0;
     };
 
+    // Chip to bit stage of a set of chip clocks, structure of arrays. Per clock the last chip and the
+    // chip count parity, per window (clock x chip offset) the previous symbol and the 26 bit shift
+    // register with its syndrome. Each window feeds a plain and an inverted path, the inverted one
+    // sees the complement of the same register
+    struct PathBank {
+        std::vector<float> last_re, last_im;
+        std::vector<uint8_t> parity;
+        std::vector<float> prev_re, prev_im;
+        std::vector<uint8_t> have_prev;
+        std::vector<uint32_t> shift;
+        std::vector<uint16_t> syndrome;
+        std::vector<uint8_t> bit_count;         // bits in the register, up to 26
+        std::vector<RdsPath> paths;             // window * 2 + inverted
+
+        void resize(size_t clocks, bool singleClock) {
+            last_re.assign(clocks, 0.0f);
+            last_im.assign(clocks, 0.0f);
+            parity.assign(clocks, 0);
+            prev_re.assign(clocks * 2, 0.0f);
+            prev_im.assign(clocks * 2, 0.0f);
+            have_prev.assign(clocks * 2, 0);
+            shift.assign(clocks * 2, 0);
+            syndrome.assign(clocks * 2, 0);
+            bit_count.assign(clocks * 2, 0);
+            paths.assign(clocks * 4, RdsPath{});
+            for (size_t p = 0; p < paths.size(); ++p) {
+                paths[p].clock_index = singleClock ? -1 : static_cast<int>(p / 4);
+            }
+        }
+    };
+
     static constexpr uint16_t kOffsetA = 0x0fc;
     static constexpr uint16_t kOffsetB = 0x198;
     static constexpr uint16_t kOffsetC = 0x168;
     static constexpr uint16_t kOffsetCp = 0x350;
     static constexpr uint16_t kOffsetD = 0x1b4;
     static constexpr uint16_t kPoly = 0x5b9;
+    static constexpr uint16_t kShiftOut = 0x0ee;      // x^26 mod g(x), a bit leaving the 26 bit window
+    static constexpr uint16_t kInvertSyndrome = 0x332; // syndrome of 26 ones, flips the syndrome of a complemented window
+    static constexpr int kMaxBurst = 5;               // longest burst the (26,16) code corrects
 
     struct DecodedBlock {
         Offset offset = Offset::Unknown;
         uint32_t corrected = 0;
-        bool corrected_one_bit = false;
+        int error_bits = 0;             // length of the corrected burst, 0 for a clean block
     };
 
-    void processChip(RdsPath& path, std::complex<float> chip) {
-        const int chip_number = path.chip_index++;
-        if ((chip_number & 1) == path.chip_offset) {
-            path.chip_pair[0] = chip;
+    // Error syndrome -> burst of up to kMaxBurst bits, all 367 such bursts have distinct syndromes
+    struct BurstTable {
+        std::array<uint32_t, 1024> pattern{};
+        std::array<uint8_t, 1024> length{};
+    };
+
+    // Baseband through the chip clocks. The single clock runs sample by sample, the bank clocks run
+    // as SIMD lanes over the block and their chips are decoded in sample order afterwards
+    void processBaseband(std::span<const std::complex<float>> x) {
+        const int64_t start = baseband_samples_;
+        if (timing_ != Timing::Bank) {
+            for (const std::complex<float>& v : x) {
+                baseband_samples_++;
+                processGardner(v);
+            }
+        } else {
+            baseband_samples_ += static_cast<int64_t>(x.size());
+        }
+        if (!bankActive()) {
+            return;
+        }
+        bank_samples_ += static_cast<int64_t>(x.size());
+
+        const size_t lanes = clock_countdown_.size();
+        const size_t max_dumps = lanes * (x.size() / static_cast<size_t>(std::max(1.0f, chip_samples_ - 1.0f)) + 2);
+        if (chip_buf_.size() < max_dumps) {
+            chip_buf_.resize(max_dumps);
+            chip_lane_.resize(max_dumps);
+            chip_when_.resize(max_dumps);
+        }
+        const size_t dumps = simd::kernels().dump_clocks(x.data(), x.size(), clock_countdown_.data(), clock_acc_re_.data(),
+                                                         clock_acc_im_.data(), lanes, chip_samples_, chip_buf_.data(),
+                                                         chip_lane_.data(), chip_when_.data());
+        for (size_t k = 0; k < dumps; ++k) {
+            now_ = start + chip_when_[k] + 1;
+            processChip(bank_, chip_lane_[k], chip_buf_[k]);
+        }
+    }
+
+    // Gardner timing on the chip matched filter output, strobes alternate between chip ends and chip
+    // middles. Linear interpolation between the two samples around a strobe gives the fractional timing
+    void processGardner(std::complex<float> x) {
+        GardnerClock& g = gardner_;
+        g.prev_box = g.box;
+        g.box += x - box_hist_[box_pos_];
+        box_hist_[box_pos_] = x;
+        box_pos_ = box_pos_ + 1 == box_len_ ? 0 : box_pos_ + 1;
+
+        g.countdown -= 1.0f;
+        if (g.countdown > 0.0f) {
+            return;
+        }
+
+        const float late = -g.countdown;       // strobe lies this far before the current sample
+        const std::complex<float> y = g.box + (g.prev_box - g.box) * late;
+        if (!g.on_time) {
+            g.mid = y;
+            g.countdown += 0.5f * chip_samples_;
+            g.on_time = true;
             return;
         }
 
-        path.chip_pair[1] = chip;
-        std::complex<float> symbol = path.chip_pair[1] - path.chip_pair[0];
+        // Transitions put the middle strobe on the zero crossing, its sign shows early or late
+        const float e = std::real((y - g.last) * std::conj(g.mid));
+        g.power = g.power > 0.0f ? g.power + 0.02f * (std::norm(y) - g.power) : std::norm(y);
+        const float err = std::clamp(e / (g.power + 1e-30f), -1.0f, 1.0f);
+        g.rate = std::clamp(g.rate + kGardnerKi * err, -0.01f, 0.01f);
+        g.countdown += (0.5f - kGardnerKp * err - g.rate) * chip_samples_;
+        g.on_time = false;
+        g.last = y;
+
+        // Exact chip sum once per chip so the running sum does not drift
+        g.box = {};
+        for (int k = 0; k < box_len_; ++k) {
+            g.box += box_hist_[k];
+        }
 
-        if (path.have_prev_symbol) {
-            float diff = std::real(symbol * std::conj(path.prev_symbol));
-            bool bit = diff < 0.0f;
-            if (path.inverted) {
-                bit = !bit;
+        now_ = baseband_samples_;
+        if (resolved_ >= 0) {
+            processChip(gardner_bank_, 0, y, resolved_ / 2);
+            if (gardner_bank_.paths[resolved_].parser.since_sync > kSyncLossBits) {
+                resolved_ = -1;
             }
-            processBit(path, bit);
+            return;
         }
+        processChip(gardner_bank_, 0, y);
+        for (size_t p = 0; p < gardner_bank_.paths.size(); ++p) {
+            if (gardner_bank_.paths[p].pi_confidence >= 2) {
+                resolved_ = static_cast<int>(p);
+                break;
+            }
+        }
+    }
 
-        path.prev_symbol = symbol;
-        path.have_prev_symbol = true;
+    // Chip from one clock of a bank. Its chip pair completes on the chip offset of opposite parity, the
+    // symbol is their difference and the bit its differential phase. onlyWindow skips the other offset
+    void processChip(PathBank& bank, size_t clock, std::complex<float> chip, int onlyWindow = -1) {
+        const size_t window = clock * 2 + (1u - bank.parity[clock]);
+        bank.parity[clock] ^= 1u;
+        const float sym_re = chip.real() - bank.last_re[clock];
+        const float sym_im = chip.imag() - bank.last_im[clock];
+        bank.last_re[clock] = chip.real();
+        bank.last_im[clock] = chip.imag();
+        if (onlyWindow >= 0 && static_cast<int>(window) != onlyWindow) {
+            return;
+        }
+
+        if (bank.have_prev[window]) {
+            const float diff = sym_re * bank.prev_re[window] + sym_im * bank.prev_im[window];
+            pushBit(bank, window, diff < 0.0f);
+        }
+        bank.prev_re[window] = sym_re;
+        bank.prev_im[window] = sym_im;
+        bank.have_prev[window] = 1;
     }
 
-    void processBit(RdsPath& path, bool bit) {
-        BlockParser& parser = path.parser;
-        parser.shift = ((parser.shift << 1) | (bit ? 1u : 0u)) & 0x03ffffffu;
-        parser.bit_count++;
+    void pushBit(PathBank& bank, size_t window, bool bit) {
+        const uint32_t in = bit ? 1u : 0u;
+        const uint32_t out = (bank.shift[window] >> 25) & 1u;
+        const uint32_t shift = ((bank.shift[window] << 1) | in) & 0x03ffffffu;
+        bank.shift[window] = shift;
+
+        // Shifting the window multiplies by x, one reduction step keeps the syndrome current
+        uint32_t syn = (static_cast<uint32_t>(bank.syndrome[window]) << 1) | in;
+        syn ^= (syn & 0x400u) ? kPoly : 0u;
+        syn ^= out ? kShiftOut : 0u;
+        bank.syndrome[window] = static_cast<uint16_t>(syn);
 
-        if (parser.bit_count < 26) {
+        if (bank.bit_count[window] < 26 && ++bank.bit_count[window] < 26) {
             return;
         }
+        processWindow(bank.paths[window * 2], shift, static_cast<uint16_t>(syn));
+        processWindow(bank.paths[window * 2 + 1], ~shift & 0x03ffffffu, static_cast<uint16_t>(syn ^ kInvertSyndrome));
+    }
 
-        DecodedBlock decoded = decodeBlock(parser.shift, path.pi_confidence >= 6);
+    // One bit position of a path, shift holds its last 26 bits and syndrome their syndrome
+    void processWindow(RdsPath& path, uint32_t shift, uint16_t syndrome) {
+        BlockParser& parser = path.parser;
+        parser.since_block = std::min(parser.since_block + 1, 1 << 30);
+        parser.since_sync = std::min(parser.since_sync + 1, 1 << 30);
+
+        // Blocks follow each other every 26 bits. Corrections are only tried one block after a valid
+        // one, and a match inside the block being assembled is a false hit that must not break the group.
+        // Longer bursts need more confidence, a third of all syndromes look like a burst of up to 5 bits
+        const bool aligned = parser.since_block == 26;
+        const int max_burst = aligned ? std::clamp(path.pi_confidence - 5, 0, kMaxBurst) : 0;
+        DecodedBlock decoded = decodeBlock(syndrome, shift, parser.expected, max_burst);
         if (decoded.offset == Offset::Unknown) {
             return;
         }
+        if (decoded.error_bits > 1 && decoded.offset == Offset::A && ((decoded.corrected >> 10) & 0xffffu) != path.pi) {
+            return;
+        }
+        if (parser.since_block < 26 && (parser.expected != 0 || parser.since_sync == parser.since_block)) {
+            return;
+        }
+
+        // Random words match an offset every ~200 bits, two blocks in a row mean block sync
+        parser.since_block = 0;
+        if (aligned) {
+            parser.since_sync = 0;
+        }
 
         uint16_t data = static_cast<uint16_t>((decoded.corrected >> 10) & 0xffffu);
-        if (decoded.corrected_one_bit) {
+        if (decoded.error_bits > 0) {
             parser.corrected_blocks++;
+            updateCounter(corrected_blocks_, parser.corrected_blocks);
         }
 
         if (decoded.offset == Offset::A) {
@@ -228,7 +441,7 @@ private:
             parser.data[0] = data;
             parser.third_is_cp = false;
             parser.local_blocks++;
-            updateBlockCounter(parser.local_blocks);
+            updateCounter(blocks_, parser.local_blocks);
             return;
         }
 
@@ -236,7 +449,7 @@ private:
             parser.expected = 2;
             parser.data[1] = data;
             parser.local_blocks++;
-            updateBlockCounter(parser.local_blocks);
+            updateCounter(blocks_, parser.local_blocks);
             return;
         }
 
@@ -245,7 +458,7 @@ private:
             parser.data[2] = data;
             parser.third_is_cp = decoded.offset == Offset::Cp;
             parser.local_blocks++;
-            updateBlockCounter(parser.local_blocks);
+            updateCounter(blocks_, parser.local_blocks);
             return;
         }
 
@@ -253,7 +466,10 @@ private:
             parser.expected = 0;
             parser.data[3] = data;
             parser.local_blocks++;
-            updateBlockCounter(parser.local_blocks);
+            updateCounter(blocks_, parser.local_blocks);
+            if (path.clock_index < 0) {
+                gardner_group_sample_ = now_;
+            }
             parseGroup(path, parser.data, parser.third_is_cp);
             return;
         }
@@ -271,6 +487,26 @@ private:
         return static_cast<uint16_t>(reg & 0x03ffu);
     }
 
+    static const BurstTable& burstTable() {
+        static const BurstTable table = [] {
+            BurstTable t;
+            for (int len = kMaxBurst; len >= 1; --len) {
+                // Bursts of len bits start and end with an error, any pattern in between
+                const uint32_t inner = len > 2 ? 1u << (len - 2) : 1u;
+                for (uint32_t mid = 0; mid < inner; ++mid) {
+                    const uint32_t burst = len == 1 ? 1u : 1u | (mid << 1) | (1u << (len - 1));
+                    for (int pos = 0; pos + len <= 26; ++pos) {
+                        const uint16_t s = syndrome(burst << pos);
+                        t.pattern[s] = burst << pos;
+                        t.length[s] = static_cast<uint8_t>(len);
+                    }
+                }
+            }
+            return t;
+        }();
+        return table;
+    }
+
     static Offset syndromeToOffset(uint16_t s) {
         if (s == kOffsetA) return Offset::A;
         if (s == kOffsetB) return Offset::B;
@@ -280,29 +516,31 @@ private:
         return Offset::Unknown;
     }
 
-    static DecodedBlock decodeBlock(uint32_t block, bool allowCorrection) {
-        const std::array<uint16_t, 5> offsets{kOffsetA, kOffsetB, kOffsetC, kOffsetCp, kOffsetD};
-        const std::array<Offset, 5> offset_names{Offset::A, Offset::B, Offset::C, Offset::Cp, Offset::D};
-        const uint16_t s = syndrome(block);
-
-        for (size_t i = 0; i < offsets.size(); ++i) {
-            if (s == offsets[i]) {
-                return {offset_names[i], block, false};
-            }
+    // s is the syndrome of block. Corrections only try the offset the group sequence expects next
+    // (C and C' for the third block), the shorter burst wins if both fit
+    static DecodedBlock decodeBlock(uint16_t s, uint32_t block, int expected, int maxBurst) {
+        const Offset exact = syndromeToOffset(s);
+        if (exact != Offset::Unknown || maxBurst <= 0) {
+            return {exact, block, 0};
         }
 
-        if (allowCorrection) {
-            for (size_t i = 0; i < offsets.size(); ++i) {
-                const uint16_t error_syndrome = static_cast<uint16_t>(s ^ offsets[i]);
-                for (int bit = 0; bit < 26; ++bit) {
-                    if (syndrome(1u << bit) == error_syndrome) {
-                        return {offset_names[i], block ^ (1u << bit), true};
-                    }
-                }
+        const BurstTable& table = burstTable();
+        const std::array<uint16_t, 4> expected_offsets{kOffsetA, kOffsetB, kOffsetC, kOffsetD};
+        const std::array<Offset, 4> expected_names{Offset::A, Offset::B, Offset::C, Offset::D};
+
+        DecodedBlock best;
+        auto tryOffset = [&](uint16_t offset, Offset name) {
+            const uint16_t error_syndrome = static_cast<uint16_t>(s ^ offset);
+            const int len = table.length[error_syndrome];
+            if (len > 0 && len <= maxBurst && (best.error_bits == 0 || len < best.error_bits)) {
+                best = {name, block ^ table.pattern[error_syndrome], len};
             }
+        };
+        tryOffset(expected_offsets[expected], expected_names[expected]);
+        if (expected == 2) {
+            tryOffset(kOffsetCp, Offset::Cp);
         }
-
-        return {};
+        return best;
     }
 
     void parseGroup(RdsPath& path, const std::array<uint16_t, 4>& block, bool thirdIsCp) {
@@ -322,8 +560,14 @@ private:
             return;
         }
 
-        updateProgramIdentification(pi);
-        synced_.store(true, std::memory_order_relaxed);
+        // Paths on neighbouring phases decode the same group within a few chips, count it once
+        const bool new_group = now_ - last_group_sample_ > group_samples_ / 2;
+        if (new_group) {
+            last_group_sample_ = now_;
+        }
+
+        updateProgramIdentification(pi, new_group);
+        synced_ = true;
 
         if (group_type == 0) {
             const int segment = b & 0x03;
@@ -344,14 +588,11 @@ private:
         }
     }
 
-    void updateProgramIdentification(uint16_t pi) {
-        std::lock_guard<std::mutex> lock(mtx_);
-
-        char pi_buf[8]{};
-        std::snprintf(pi_buf, sizeof(pi_buf), "%04X", pi);
-
-        if (pi_ != pi_buf) {
-            pi_ = pi_buf;
+    void updateProgramIdentification(uint16_t pi, bool newGroup) {
+        if (!have_pi_ || pi_ != pi) {
+            pi_ = pi;
+            have_pi_ = true;
+            dirty_ = true;
             std::fill(program_service_.begin(), program_service_.end(), ' ');
             std::fill(radio_text_.begin(), radio_text_.end(), ' ');
             ps_candidate_count_.fill(0);
@@ -359,12 +600,17 @@ private:
             have_text_ab_ = false;
         }
 
-        groups_++;
+        if (newGroup) {
+            groups_++;
+            dirty_ = true;
+        }
     }
 
-    void updateBlockCounter(uint64_t pathBlocks) {
-        uint64_t old = blocks_.load(std::memory_order_relaxed);
-        while (pathBlocks > old && !blocks_.compare_exchange_weak(old, pathBlocks, std::memory_order_relaxed)) {
+    // Counters report the best path
+    void updateCounter(uint64_t& counter, uint64_t pathCount) {
+        if (pathCount > counter) {
+            counter = pathCount;
+            dirty_ = true;
         }
     }
 
@@ -378,7 +624,6 @@ private:
         const char hi = sanitizeChar(raw_hi);
         const char lo = sanitizeChar(raw_lo);
 
-        std::lock_guard<std::mutex> lock(mtx_);
         if (ps_candidate_[segment][0] == hi && ps_candidate_[segment][1] == lo) {
             ps_candidate_count_[segment] = std::min<uint8_t>(3, ps_candidate_count_[segment] + 1);
         } else {
@@ -390,6 +635,7 @@ private:
         if (ps_candidate_count_[segment] >= 2) {
             program_service_[segment * 2] = hi;
             program_service_[segment * 2 + 1] = lo;
+            dirty_ = true;
         }
     }
 
@@ -403,7 +649,6 @@ private:
         const char hi = sanitizeChar(raw_hi);
         const char lo = sanitizeChar(raw_lo);
 
-        std::lock_guard<std::mutex> lock(mtx_);
         if (have_text_ab_ && textAb != text_ab_) {
             std::fill(radio_text_.begin(), radio_text_.end(), ' ');
             rt_candidate_count_.fill(0);
@@ -424,6 +669,7 @@ private:
         if (rt_candidate_count_[pair_index] >= 1) {
             radio_text_[offset] = hi;
             radio_text_[offset + 1] = lo;
+            dirty_ = true;
 
             if (raw_hi == '\r' || raw_lo == '\r') {
                 const int end = raw_hi == '\r' ? offset : offset + 1;
@@ -434,6 +680,27 @@ private:
         }
     }
 
+    // First of the two decimation stages, the largest divisor of the total up to its square root
+    static int firstStageDecimation(int decim) {
+        for (int d = static_cast<int>(std::sqrt(static_cast<double>(decim))); d > 1; --d) {
+            if (decim % d == 0) return d;
+        }
+        return 1;
+    }
+
+    // Stage one only keeps images off the +-4kHz channel after its decimation
+    static std::vector<float> mixTaps(float sampleRate, int decim) {
+        if (decim == 1) return {1.0f};
+        const double rate = sampleRate / decim;
+        return design::kaiser_lowpass({sampleRate, 0.5 * (kChannelPass + rate - kChannelStop),
+                                       rate - kChannelStop - kChannelPass, 50.0});
+    }
+
+    // Stage two is the channel filter, passes the RDS band and stops the L-R sideband
+    static std::vector<float> channelTaps(float sampleRate) {
+        return design::kaiser_lowpass({sampleRate, 0.5 * (kChannelPass + kChannelStop), kChannelStop - kChannelPass, 50.0});
+    }
+
     static char sanitizeChar(char c) {
         unsigned char uc = static_cast<unsigned char>(c);
         if (uc >= 32 && uc <= 126) {
@@ -442,31 +709,74 @@ private:
         return ' ';
     }
 
-    static std::string trimCopy(const std::array<char, 8>& value) {
-        return trimCopy(std::string(value.begin(), value.end()));
+    // Text without trailing spaces, the rest of the buffer zeroed so equal texts compare equal
+    template <size_t N>
+    static void trimCopy(RdsText<N>& dst, const std::array<char, N>& value) {
+        size_t len = N;
+        while (len > 0 && value[len - 1] == ' ') {
+            --len;
+        }
+        std::memset(dst.chars, 0, sizeof(dst.chars));
+        std::memcpy(dst.chars, value.data(), len);
     }
 
-    static std::string trimCopy(const std::array<char, 64>& value) {
-        return trimCopy(std::string(value.begin(), value.end()));
-    }
+    // Readers see a new version only when something they show has changed
+    void publishIfChanged() {
+        const bool bank = bankActive();
+        if (!dirty_ && bank == image_.timing_bank) {
+            return;
+        }
+        dirty_ = false;
 
-    static std::string trimCopy(std::string value) {
-        while (!value.empty() && value.back() == ' ') {
-            value.pop_back();
+        image_.version++;
+        image_.synced = synced_;
+        std::memset(image_.pi.chars, 0, sizeof(image_.pi.chars));
+        if (have_pi_) {
+            std::snprintf(image_.pi.chars, sizeof(image_.pi.chars), "%04X", pi_);
         }
-        return value;
+        trimCopy(image_.program_service, program_service_);
+        trimCopy(image_.radio_text, radio_text_);
+        image_.groups = groups_;
+        image_.blocks = blocks_;
+        image_.corrected_blocks = corrected_blocks_;
+        image_.timing_bank = bank;
+        published_.publish(image_);
     }
 
-    float chip_samples_;
-    BiquadBandpass rds_bandpass_;
-    std::vector<ChipClock> clocks_;
-    std::vector<RdsPath> paths_;
-
-    mutable std::mutex mtx_;
-    std::atomic<bool> synced_{false};
-    std::atomic<uint64_t> blocks_{0};
+    Timing timing_;
+    int decim_;                                             // MPX to baseband decimation
+    float baseband_rate_;
+    float chip_samples_;                                    // baseband samples per chip
+    FIRFilter<std::complex<float>> mix_lpf_;                // MPX rate, mixed input
+    FIRFilter<std::complex<float>> channel_lpf_;
+    std::vector<std::complex<float>> mix_buf_, baseband_buf_;
+    std::vector<float> clock_countdown_, clock_acc_re_, clock_acc_im_;     // bank clocks, one SIMD lane each
+    PathBank bank_;
+    std::vector<std::complex<float>> chip_buf_;             // bank chips of the current block
+    std::vector<uint16_t> chip_lane_;
+    std::vector<uint32_t> chip_when_;
+    GardnerClock gardner_;
+    std::array<std::complex<float>, 32> box_hist_{};        // last chip of baseband samples
+    int box_len_ = 1;
+    int box_pos_ = 0;
+    PathBank gardner_bank_;                                 // chip offset x polarity on the single clock
+    int resolved_ = -1;                                     // gardner path holding sync, -1 while searching
+    PathBank bit_bank_;                                     // parsers for processBits()
+    int64_t baseband_samples_ = 0;
+    int64_t now_ = 0;                                       // baseband sample of the chip being decoded
+    int64_t bank_samples_ = 0;
+    int64_t gardner_group_sample_ = 0;                      // last complete group on the single clock
+    int64_t fallback_samples_ = 0;
+    int64_t last_group_sample_ = -(int64_t{1} << 40);
+    int64_t group_samples_ = 0;
+
+    // Decoded state, DSP thread only
+    bool synced_ = false;
+    uint64_t blocks_ = 0;
+    uint64_t corrected_blocks_ = 0;
     uint64_t groups_ = 0;
-    std::string pi_;
+    uint16_t pi_ = 0;
+    bool have_pi_ = false;
     std::array<char, 8> program_service_{' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '};
     std::array<char, 64> radio_text_{};
     std::array<std::array<char, 2>, 4> ps_candidate_{};
@@ -475,4 +785,9 @@ private:
     std::array<uint8_t, 32> rt_candidate_count_{};
     bool have_text_ab_ = false;
     bool text_ab_ = false;
+
+    // Published state: image_ is the writer's copy, readers copy it out of published_
+    bool dirty_ = true;
+    RdsSnapshot image_;
+    SeqlockBuffer<RdsSnapshot> published_;
 };
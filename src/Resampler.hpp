@@ -0,0 +1,237 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <complex>
+#include <span>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include "SimdKernels.hpp"
+#include "ChannelFrame.hpp"
+#include "FilterDesign.hpp"
+
+/*!
+\brief	Polyphase sample rate converter for audio streams (float or ChannelFrame<2>).
+        Integer rates with a small reduced ratio L/M run the exact rational form: one Kaiser prototype
+        at L * in_rate split into L sub-filters, each output is one sub-filter dot product.
+        Any other ratio uses 256 phases and a 32.32 fixed point step, the output blends the two
+        neighbouring sub-filters linearly. Equal rates bypass the filter. A variable resampler always
+        runs the fractional form so its ratio can be trimmed by a few hundred ppm while streaming.
+*/
+template <typename T>
+class PolyphaseResampler {
+public:
+    static constexpr int kMaxRationalPhases = 512;     // larger L falls back to the fractional form
+    static constexpr int kFractionalPhases = 256;
+    static constexpr double kMaxTrim = 1e-3;           // set_ratio_scale() range, 1 +- 1000 ppm
+
+    /*!
+    \brief		Design the prototype for in_rate -> out_rate
+    \param 		passband - Highest frequency kept flat, capped at 80% of the lower Nyquist rate
+    \param 		atten - Stopband attenuation in dB, the stopband starts at the lower Nyquist rate
+    \param 		variable - Keep the ratio adjustable with set_ratio_scale(), no bypass or rational form
+    */
+    PolyphaseResampler(double in_rate, double out_rate, double passband = 15000.0, double atten = 80.0,
+                       bool variable = false)
+        : fin(in_rate), fout(out_rate) {
+        if (in_rate == out_rate && !variable) return;
+
+        const bool integer_rates = in_rate == std::floor(in_rate) && out_rate == std::floor(out_rate);
+        if (integer_rates && !variable) {
+            const uint64_t g = std::gcd((uint64_t)in_rate, (uint64_t)out_rate);
+            const uint64_t up = (uint64_t)out_rate / g, down = (uint64_t)in_rate / g;
+            if (up <= (uint64_t)kMaxRationalPhases) {
+                L = (int)up;
+                M = (int)down;
+                rational = true;
+            }
+        }
+        if (!rational) {
+            L = kFractionalPhases;
+            set_ratio_scale(1.0);
+        }
+
+        // Prototype at L * in_rate, each phase keeps unity DC gain
+        const double fstop = 0.5 * std::min(in_rate, out_rate);
+        const double fpass = std::min(passband, 0.8 * fstop);
+        const double rate = in_rate * L;
+        N = std::max(1, (design::kaiser_numtaps(atten, fstop - fpass, rate) + L - 1) / L);
+        const std::vector<float> h = design::firwin(N * L, 0.5 * (fpass + fstop), design::kaiser_beta(atten), rate);
+
+        // Sub-filter p in time order (oldest sample first): b[p][j] = h[(N-1-j) * L + p].
+        // The fractional form keeps one extra phase L, phase 0 one input sample later.
+        const int phases = rational ? L : L + 1;
+        bank.assign((size_t)phases * N, 0.0f);
+        for (int p = 0; p < phases; p++) {
+            for (int j = 0; j < N; j++) {
+                const size_t k = (size_t)(N - 1 - j) * L + p;
+                bank[(size_t)p * N + j] = k < h.size() ? h[k] * (float)L : 0.0f;
+            }
+        }
+
+        x.assign(N - 1 + std::max<size_t>(4 * (size_t)N, 4096), T{});
+        pos = N - 1;
+    }
+
+    /*!
+    \brief		Convert one block
+    \param 		out - Needs room for max_output(in.size()) samples
+    \return     Number of output samples written to out
+    */
+    size_t process(std::span<const T> in, std::span<T> out) {
+        if (bypass()) {
+            std::copy(in.begin(), in.end(), out.begin());
+            return in.size();
+        }
+
+        size_t n_out = 0;
+        for (const T& s : in) {
+            if (pos == (int)x.size()) compact();    // slide history back to the start of the window
+            x[pos++] = s;
+            if (--skip > 0) continue;               // next output still lies ahead
+
+            const T* w = x.data() + pos - N;
+            while (skip == 0) {
+                if (rational) {
+                    out[n_out++] = dot(w, acc);
+                    acc += M;
+                    skip = acc / L;
+                    acc %= L;
+                }
+                else {
+                    const int p = (int)(frac >> 24);                                   // top 8 bits of the Q32 fraction
+                    const float t = (float)(frac & 0xFFFFFF) * (1.0f / 16777216.0f);   // position between phases p and p+1
+                    const T a = dot(w, p), b = dot(w, p + 1);
+                    out[n_out++] = a * (1.0f - t) + b * t;
+                    frac += step;
+                    skip = (int)(frac >> 32);
+                    frac &= 0xFFFFFFFFull;
+                }
+            }
+        }
+        return n_out;
+    }
+
+    /*!
+    \brief		Scale the input step of the fractional form, s > 1 produces fewer outputs per input.
+                Takes effect on the next output, the filter state and phase are kept.
+    */
+    void set_ratio_scale(double s) {
+        if (rational || bypass()) return;
+        scale = std::clamp(s, 1.0 - kMaxTrim, 1.0 + kMaxTrim);
+        step = (uint64_t)std::llround(fin / fout * scale * 4294967296.0);    // input samples per output, Q32
+    }
+
+    double ratio_scale() const { return scale; }
+
+    // Upper bound on the outputs produced from n inputs, with room for ratio trims up to kMaxTrim
+    size_t max_output(size_t n) const {
+        return bypass() ? n : (size_t)std::ceil((double)n * fout / fin * (1.0 + kMaxTrim)) + 2;
+    }
+
+    bool bypass() const { return L == 0; }
+    bool is_rational() const { return rational; }
+    int phases() const { return L; }
+    int taps_per_phase() const { return N; }
+    double input_rate() const { return fin; }
+    double output_rate() const { return fout; }
+
+    // Group delay in input samples
+    double group_delay() const { return bypass() ? 0.0 : (N * L - 1) / 2.0 / L; }
+
+    // Tap multiplies per output sample
+    float macs_per_output() const { return bypass() ? 0.0f : (float)(rational ? N : 2 * N); }
+
+    std::string describe() const {
+        if (bypass()) return "bypass";
+        return (rational ? "rational " + std::to_string(L) + "/" + std::to_string(M)
+                         : "fractional " + std::to_string(L) + " phases")
+               + ", " + std::to_string(N) + " taps/phase";
+    }
+
+private:
+    // Sub-filter p applied to the window ending at the newest sample
+    T dot(const T* w, int p) const {
+        const float* b = bank.data() + (size_t)p * N;
+
+        if constexpr (std::is_same_v<T, float>) {
+            return kern->dot_f32(w, b, N);
+        } else if constexpr (std::is_same_v<T, ChannelFrame<2>>) {
+            // Two lanes with real taps are exactly a complex<float> dot product
+            const std::complex<float> r = kern->dot_cf32(reinterpret_cast<const std::complex<float>*>(w), b, N);
+            return ChannelFrame<2>{{r.real(), r.imag()}};
+        } else {
+            T acc{};
+            for (int k = 0; k < N; k++) acc += w[k] * b[k];
+            return acc;
+        }
+    }
+
+    // Move the newest N-1 samples back to the front of the window
+    void compact() {
+        std::copy(x.end() - (N - 1), x.end(), x.begin());
+        pos = N - 1;
+    }
+
+    double fin, fout;
+    bool rational = false;
+    int L = 0;                      // phases, 0 = bypass
+    int M = 0;                      // rational decimation
+    int N = 0;                      // taps per phase
+    std::vector<float> bank;        // sub-filters, phase major
+    std::vector<T> x;               // sliding window of input samples, N-1 history + free space
+    int pos = 0;                    // write position in the window
+    int skip = 1;                   // input samples to consume before the next output
+    int acc = 0;                    // rational phase, 0..L-1
+    uint64_t step = 0;              // fractional input step per output, Q32
+    uint64_t frac = 0;              // fractional phase, Q32
+    double scale = 1.0;             // step trim of the variable form
+    const simd::KernelTable* kern = &simd::kernels();
+};
+
+/*!
+\brief	Sample rate layout derived from the dongle rate and the requested MPX and output rates:
+        fs -(mpx_decim)-> mpx_rate -(audio_decim)-> audio_rate -(resampler)-> output_rate.
+        The MPX rate is the lowest exact integer decimation of fs at or above the requested one, the
+        audio rate the lowest exact decimation of the MPX rate that still carries the 19kHz notch and
+        covers the output rate, so the resampler always runs at the lowest rate. 2.048 MS/s gives
+        512k MPX and 51.2k audio, resampled 15/16 to 48k or 441/512 to 44.1k.
+*/
+struct RatePlan {
+    static constexpr double kMinAudioRate = 40000.0;    // 19kHz pilot notch and 15kHz audio need > 38k
+
+    uint32_t fs = 2'400'000;        // dongle sample rate
+    int mpx_decim = 5;              // first stage decimation
+    int audio_decim = 10;           // second stage decimation
+    double output_rate = 48000.0;   // sink rate (PortAudio / WAV)
+
+    static RatePlan derive(uint32_t fs, uint32_t mpx_target, double output_rate) {
+        RatePlan plan;
+        plan.fs = fs;
+        plan.output_rate = output_rate;
+        plan.mpx_decim = largest_divisor(fs, (int)(fs / mpx_target));
+        plan.audio_decim = largest_divisor(plan.mpx_rate(), (int)(plan.mpx_rate() / std::max(output_rate, kMinAudioRate)));
+        return plan;
+    }
+
+    uint32_t mpx_rate() const { return fs / mpx_decim; }
+    uint32_t audio_rate() const { return mpx_rate() / audio_decim; }
+
+    std::string describe() const {
+        return std::to_string(fs) + " /" + std::to_string(mpx_decim) + " -> " + std::to_string(mpx_rate())
+               + " /" + std::to_string(audio_decim) + " -> " + std::to_string(audio_rate())
+               + " -> " + std::to_string((uint32_t)output_rate) + " S/s";
+    }
+
+private:
+    // Largest d <= limit dividing n, at least 1
+    static int largest_divisor(uint32_t n, int limit) {
+        for (int d = limit; d > 1; d--) {
+            if (n % d == 0) return d;
+        }
+        return 1;
+    }
+};
@@ -2,12 +2,15 @@
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <complex>
+#include "SimdKernels.hpp"
 
 class RfFFTAnalyzer {
 public:
     RfFFTAnalyzer(int fft_size, int sample_rate)
         : N(fft_size), fs(sample_rate),
           window(N),
+          power(N),
           in((fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * N)),
           out((fftwf_complex*)fftwf_malloc(sizeof(fftwf_complex) * N))
     {
@@ -42,15 +45,16 @@ public:
 
         fftwf_execute(plan);
 
+        // |X|^2 for all bins in one vectorized pass
+        simd::kernels().mag2(reinterpret_cast<const std::complex<float>*>(out), power.data(), N);
+
         // power -> dB, then fftshift into dst
         const float eps = 1e-20f;
         const float norm = 1.0f / (float)(N * N);
 
         int half = N / 2;
         for (int k = 0; k < N; ++k) {
-            float re = out[k][0];
-            float im = out[k][1];
-            float p = (re*re + im*im) * norm;
+            float p = power[k] * norm;
             float db = 10.0f * std::log10(p + eps);
             if (db < db_floor) db = db_floor;
 
@@ -62,6 +66,7 @@ public:
 private:
     int N, fs;
     std::vector<float> window;
+    std::vector<float> power;           // |X|^2 scratch
     fftwf_complex* in;
     fftwf_complex* out;
     fftwf_plan plan;
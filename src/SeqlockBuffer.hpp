@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Latest value of a small fixed-size struct, one writer thread and any number of readers.
+// The writer never waits: it bumps the sequence to odd, stores the words and bumps it to even.
+// A reader copies the words between two reads of the sequence and retries if a write overlapped.
+// The payload is held in relaxed atomic words, so a torn copy is a retry and not a data race.
+template <typename T>
+class SeqlockBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqlockBuffer copies the payload as raw words");
+
+public:
+    // Writer thread only
+    void publish(const T& value) {
+        std::array<uint64_t, kWords> words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+
+        const uint64_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);         // odd: write in progress
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kWords; i++) {
+            data_[i].store(words[i], std::memory_order_relaxed);
+        }
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // Number of publishes so far, a reader that already holds this version can skip read()
+    uint64_t version() const { return seq_.load(std::memory_order_acquire) / 2; }
+
+    // Any thread, never blocks the writer
+    T read() const {
+        std::array<uint64_t, kWords> words;
+        for (;;) {
+            const uint64_t seq = seq_.load(std::memory_order_acquire);
+            if (seq & 1) continue;                              // writer is mid-copy, a few hundred bytes
+            for (size_t i = 0; i < kWords; i++) {
+                words[i] = data_[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq_.load(std::memory_order_relaxed) == seq) break;
+        }
+
+        T value;
+        std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    std::atomic<uint64_t> seq_{0};
+    std::array<std::atomic<uint64_t>, kWords> data_{};
+};
@@ -0,0 +1,1037 @@
+#include "SimdKernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SIMD_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#else
+#define SIMD_X86 0
+#endif
+
+// GCC/Clang need per-function target attributes to emit AVX code in a baseline build,
+// MSVC accepts the intrinsics anywhere.
+#if SIMD_X86 && (defined(__GNUC__) || defined(__clang__))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define SIMD_TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define SIMD_TARGET_AVX2
+#define SIMD_TARGET_AVX512
+#endif
+
+namespace simd {
+namespace {
+
+using cf32 = std::complex<float>;
+
+////////////////////////////////////////////////////////
+// Scalar reference kernels
+////////////////////////////////////////////////////////
+
+float dot_f32_scalar(const float* x, const float* h, size_t n) {
+    float acc[4] = {};
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        for (int j = 0; j < 4; j++) acc[j] += x[k + j] * h[k + j];
+    }
+    for (; k < n; k++) acc[0] += x[k] * h[k];
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+cf32 dot_cf32_scalar(const cf32* x, const float* h, size_t n) {
+    const float* xf = reinterpret_cast<const float*>(x);
+    float re = 0.0f, im = 0.0f;
+    for (size_t k = 0; k < n; k++) {
+        re += xf[2*k] * h[k];
+        im += xf[2*k + 1] * h[k];
+    }
+    return {re, im};
+}
+
+float dot_sym_f32_scalar(const float* w, const float* h, size_t n) {
+    const size_t half = n / 2;
+    float acc = 0.0f;
+    for (size_t k = 0; k < half; k++) acc += (w[k] + w[n - 1 - k]) * h[k];
+    if (n & 1) acc += w[half] * h[half];
+    return acc;
+}
+
+cf32 dot_sym_cf32_scalar(const cf32* w, const float* h, size_t n) {
+    const float* wf = reinterpret_cast<const float*>(w);
+    const size_t half = n / 2;
+    float re = 0.0f, im = 0.0f;
+    for (size_t k = 0; k < half; k++) {
+        re += (wf[2*k] + wf[2*(n - 1 - k)]) * h[k];
+        im += (wf[2*k + 1] + wf[2*(n - 1 - k) + 1]) * h[k];
+    }
+    if (n & 1) {
+        re += wf[2*half] * h[half];
+        im += wf[2*half + 1] * h[half];
+    }
+    return {re, im};
+}
+
+void cmul_scalar(const cf32* a, const cf32* b, cf32* out, size_t n) {
+    const float* af = reinterpret_cast<const float*>(a);
+    const float* bf = reinterpret_cast<const float*>(b);
+    float* of = reinterpret_cast<float*>(out);
+    for (size_t i = 0; i < n; i++) {
+        const float ar = af[2*i], ai = af[2*i + 1];
+        const float br = bf[2*i], bi = bf[2*i + 1];
+        of[2*i] = ar * br - ai * bi;
+        of[2*i + 1] = ar * bi + ai * br;
+    }
+}
+
+void mag2_scalar(const cf32* x, float* out, size_t n) {
+    const float* xf = reinterpret_cast<const float*>(x);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = xf[2*i] * xf[2*i] + xf[2*i + 1] * xf[2*i + 1];
+    }
+}
+
+void f32_to_s16_scalar(const float* in, int16_t* out, size_t n, float scale) {
+    for (size_t i = 0; i < n; i++) {
+        float x = std::clamp(in[i], -1.0f, 1.0f);
+        out[i] = static_cast<int16_t>(std::lrintf(x * scale));
+    }
+}
+
+void s16_to_f32_scalar(const int16_t* in, float* out, size_t n, float scale) {
+    for (size_t i = 0; i < n; i++) out[i] = static_cast<float>(in[i]) * scale;
+}
+
+void u8_to_f32_scalar(const uint8_t* in, float* out, size_t n, float offset, float scale) {
+    for (size_t i = 0; i < n; i++) out[i] = (static_cast<float>(in[i]) + offset) * scale;
+}
+
+void atan2_f32_scalar(const float* y, const float* x, float* out, size_t n) {
+    for (size_t i = 0; i < n; i++) out[i] = atan2_poly(y[i], x[i]);
+}
+
+size_t dump_clocks_scalar(const cf32* x, size_t n, float* countdown, float* acc_re, float* acc_im,
+                          size_t lanes, float period, cf32* chips, uint16_t* lane, uint32_t* when) {
+    size_t dumps = 0;
+    for (size_t i = 0; i < n; i++) {
+        const float xr = x[i].real(), xi = x[i].imag();
+        for (size_t l = 0; l < lanes; l++) {
+            const float c = countdown[l] - 1.0f;
+            const float late = c > 0.0f ? 0.0f : -c;       // share of the sample after the boundary
+            const float w = 1.0f - late;
+            const float re = acc_re[l] + xr * w, im = acc_im[l] + xi * w;
+            if (c > 0.0f) {
+                countdown[l] = c;
+                acc_re[l] = re;
+                acc_im[l] = im;
+                continue;
+            }
+            chips[dumps] = {re, im};
+            lane[dumps] = static_cast<uint16_t>(l);
+            when[dumps] = static_cast<uint32_t>(i);
+            dumps++;
+            countdown[l] = c + period;
+            acc_re[l] = xr * late;
+            acc_im[l] = xi * late;
+        }
+    }
+    return dumps;
+}
+
+size_t cic_u8_scalar(const uint8_t* iq, size_t n, uint32_t* integ, uint32_t* comb, int order, int decim,
+                     int* phase, float scale, cf32* out) {
+    int ph = *phase;
+    size_t produced = 0;
+    for (size_t i = 0; i < n; i++) {
+        // (b - 127.5) * 2, exact odd integers
+        uint32_t vi = 2u * iq[2*i] - 255u, vq = 2u * iq[2*i + 1] - 255u;
+        for (int s = 0; s < order; s++) {
+            vi = integ[2*s] += vi;
+            vq = integ[2*s + 1] += vq;
+        }
+        if (++ph < decim) continue;
+        ph = 0;
+        for (int s = 0; s < order; s++) {
+            const uint32_t di = vi - comb[2*s], dq = vq - comb[2*s + 1];
+            comb[2*s] = vi;
+            comb[2*s + 1] = vq;
+            vi = di;
+            vq = dq;
+        }
+        out[produced++] = {static_cast<float>(static_cast<int32_t>(vi)) * scale,
+                           static_cast<float>(static_cast<int32_t>(vq)) * scale};
+    }
+    *phase = ph;
+    return produced;
+}
+
+#if SIMD_X86
+
+////////////////////////////////////////////////////////
+// SSE2 kernels
+////////////////////////////////////////////////////////
+
+inline float hsum128(__m128 v) {
+    __m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+// [re0 im0 re1 im1] -> complex sum of both lanes
+inline cf32 csum128(__m128 v) {
+    __m128 s = _mm_add_ps(v, _mm_movehl_ps(v, v));
+    alignas(16) float f[4];
+    _mm_store_ps(f, s);
+    return {f[0], f[1]};
+}
+
+inline __m128 reverse128(__m128 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3)); }
+inline __m128 creverse128(__m128 v) { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)); }
+
+float dot_f32_sse2(const float* x, const float* h, size_t n) {
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(x + k), _mm_loadu_ps(h + k)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(x + k + 4), _mm_loadu_ps(h + k + 4)));
+    }
+    float acc = hsum128(_mm_add_ps(acc0, acc1));
+    for (; k < n; k++) acc += x[k] * h[k];
+    return acc;
+}
+
+cf32 dot_cf32_sse2(const cf32* x, const float* h, size_t n) {
+    const float* xf = reinterpret_cast<const float*>(x);
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    size_t k = 0;
+    for (; k + 4 <= n; k += 4) {
+        __m128 t = _mm_loadu_ps(h + k);
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(xf + 2*k), _mm_unpacklo_ps(t, t)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(xf + 2*k + 4), _mm_unpackhi_ps(t, t)));
+    }
+    cf32 acc = csum128(_mm_add_ps(acc0, acc1));
+    cf32 tail = dot_cf32_scalar(x + k, h + k, n - k);
+    return {acc.real() + tail.real(), acc.imag() + tail.imag()};
+}
+
+float dot_sym_f32_sse2(const float* w, const float* h, size_t n) {
+    const size_t half = n / 2;
+    __m128 acc = _mm_setzero_ps();
+    size_t k = 0;
+    for (; k + 4 <= half; k += 4) {
+        __m128 s = _mm_add_ps(_mm_loadu_ps(w + k), reverse128(_mm_loadu_ps(w + n - 4 - k)));
+        acc = _mm_add_ps(acc, _mm_mul_ps(s, _mm_loadu_ps(h + k)));
+    }
+    float sum = hsum128(acc);
+    for (; k < half; k++) sum += (w[k] + w[n - 1 - k]) * h[k];
+    if (n & 1) sum += w[half] * h[half];
+    return sum;
+}
+
+cf32 dot_sym_cf32_sse2(const cf32* w, const float* h, size_t n) {
+    const float* wf = reinterpret_cast<const float*>(w);
+    const size_t half = n / 2;
+    __m128 acc0 = _mm_setzero_ps(), acc1 = _mm_setzero_ps();
+    size_t k = 0;
+    for (; k + 4 <= half; k += 4) {
+        __m128 t = _mm_loadu_ps(h + k);
+        __m128 s0 = _mm_add_ps(_mm_loadu_ps(wf + 2*k), creverse128(_mm_loadu_ps(wf + 2*(n - 2 - k))));
+        __m128 s1 = _mm_add_ps(_mm_loadu_ps(wf + 2*k + 4), creverse128(_mm_loadu_ps(wf + 2*(n - 4 - k))));
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(s0, _mm_unpacklo_ps(t, t)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(s1, _mm_unpackhi_ps(t, t)));
+    }
+    cf32 acc = csum128(_mm_add_ps(acc0, acc1));
+    float re = acc.real(), im = acc.imag();
+    for (; k < half; k++) {
+        re += (wf[2*k] + wf[2*(n - 1 - k)]) * h[k];
+        im += (wf[2*k + 1] + wf[2*(n - 1 - k) + 1]) * h[k];
+    }
+    if (n & 1) {
+        re += wf[2*half] * h[half];
+        im += wf[2*half + 1] * h[half];
+    }
+    return {re, im};
+}
+
+void cmul_sse2(const cf32* a, const cf32* b, cf32* out, size_t n) {
+    const float* af = reinterpret_cast<const float*>(a);
+    const float* bf = reinterpret_cast<const float*>(b);
+    float* of = reinterpret_cast<float*>(out);
+    const __m128 sign = _mm_castsi128_ps(_mm_set_epi32(0, (int)0x80000000, 0, (int)0x80000000));
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128 va = _mm_loadu_ps(af + 2*i);
+        __m128 vb = _mm_loadu_ps(bf + 2*i);
+        __m128 b_re = _mm_shuffle_ps(vb, vb, _MM_SHUFFLE(2, 2, 0, 0));
+        __m128 b_im = _mm_shuffle_ps(vb, vb, _MM_SHUFFLE(3, 3, 1, 1));
+        __m128 a_sw = _mm_shuffle_ps(va, va, _MM_SHUFFLE(2, 3, 0, 1));
+        // [ar*br - ai*bi, ai*br + ar*bi]
+        __m128 r = _mm_add_ps(_mm_mul_ps(va, b_re), _mm_xor_ps(_mm_mul_ps(a_sw, b_im), sign));
+        _mm_storeu_ps(of + 2*i, r);
+    }
+    cmul_scalar(a + i, b + i, out + i, n - i);
+}
+
+void mag2_sse2(const cf32* x, float* out, size_t n) {
+    const float* xf = reinterpret_cast<const float*>(x);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v0 = _mm_loadu_ps(xf + 2*i);
+        __m128 v1 = _mm_loadu_ps(xf + 2*i + 4);
+        v0 = _mm_mul_ps(v0, v0);
+        v1 = _mm_mul_ps(v1, v1);
+        __m128 re = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 im = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1));
+        _mm_storeu_ps(out + i, _mm_add_ps(re, im));
+    }
+    mag2_scalar(x + i, out + i, n - i);
+}
+
+void f32_to_s16_sse2(const float* in, int16_t* out, size_t n, float scale) {
+    const __m128 lo = _mm_set1_ps(-1.0f), hi = _mm_set1_ps(1.0f), s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), lo), hi), s);
+        __m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), lo), hi), s);
+        __m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), packed);
+    }
+    f32_to_s16_scalar(in + i, out + i, n - i, scale);
+}
+
+void s16_to_f32_sse2(const int16_t* in, float* out, size_t n, float scale) {
+    const __m128 s = _mm_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);     // sign extend
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(lo), s));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), s));
+    }
+    s16_to_f32_scalar(in + i, out + i, n - i, scale);
+}
+
+void u8_to_f32_sse2(const uint8_t* in, float* out, size_t n, float offset, float scale) {
+    const __m128 o = _mm_set1_ps(offset), s = _mm_set1_ps(scale);
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);        // zero extend to 16 bit
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        __m128i w[4] = {_mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+                        _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero)};
+        for (int j = 0; j < 4; j++) {
+            _mm_storeu_ps(out + i + 4*j, _mm_mul_ps(_mm_add_ps(_mm_cvtepi32_ps(w[j]), o), s));
+        }
+    }
+    u8_to_f32_scalar(in + i, out + i, n - i, offset, scale);
+}
+
+void atan2_f32_sse2(const float* y, const float* x, float* out, size_t n) {
+    const __m128 sign = _mm_set1_ps(-0.0f), zero = _mm_setzero_ps();
+    const __m128 pi = _mm_set1_ps(kPi), half_pi = _mm_set1_ps(kHalfPi);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m128 vy = _mm_loadu_ps(y + i), vx = _mm_loadu_ps(x + i);
+        const __m128 ax = _mm_andnot_ps(sign, vx), ay = _mm_andnot_ps(sign, vy);
+        const __m128 mx = _mm_max_ps(ax, ay), mn = _mm_min_ps(ax, ay);
+        const __m128 z = _mm_and_ps(_mm_div_ps(mn, mx), _mm_cmpgt_ps(mx, zero));    // 0/0 -> 0
+        const __m128 z2 = _mm_mul_ps(z, z);
+        __m128 p = _mm_set1_ps(kAtanC[5]);
+        for (int k = 4; k >= 0; k--) p = _mm_add_ps(_mm_mul_ps(p, z2), _mm_set1_ps(kAtanC[k]));
+        __m128 r = _mm_mul_ps(z, p);
+
+        const __m128 swap = _mm_cmpgt_ps(ay, ax);
+        r = _mm_or_ps(_mm_and_ps(swap, _mm_sub_ps(half_pi, r)), _mm_andnot_ps(swap, r));
+        const __m128 left = _mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(vx), 31));
+        r = _mm_or_ps(_mm_and_ps(left, _mm_sub_ps(pi, r)), _mm_andnot_ps(left, r));
+        _mm_storeu_ps(out + i, _mm_or_ps(r, _mm_and_ps(vy, sign)));
+    }
+    atan2_f32_scalar(y + i, x + i, out + i, n - i);
+}
+
+// Lanes of a dump mask in ascending order
+inline size_t emit_dumps(unsigned mask, size_t base, uint32_t i, const float* re, const float* im,
+                         cf32* chips, uint16_t* lane, uint32_t* when, size_t dumps) {
+    for (size_t b = 0; mask; b++, mask >>= 1) {
+        if (!(mask & 1)) continue;
+        chips[dumps] = {re[b], im[b]};
+        lane[dumps] = static_cast<uint16_t>(base + b);
+        when[dumps] = i;
+        dumps++;
+    }
+    return dumps;
+}
+
+// Countdowns follow the scalar kernel exactly, so every variant dumps on the same samples
+size_t dump_clocks_sse2(const cf32* x, size_t n, float* countdown, float* acc_re, float* acc_im,
+                        size_t lanes, float period, cf32* chips, uint16_t* lane, uint32_t* when) {
+    if (lanes % 4) return dump_clocks_scalar(x, n, countdown, acc_re, acc_im, lanes, period, chips, lane, when);
+    const __m128 one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps(), per = _mm_set1_ps(period);
+    size_t dumps = 0;
+    for (size_t i = 0; i < n; i++) {
+        const __m128 xr = _mm_set1_ps(x[i].real()), xi = _mm_set1_ps(x[i].imag());
+        for (size_t l = 0; l < lanes; l += 4) {
+            const __m128 c = _mm_sub_ps(_mm_loadu_ps(countdown + l), one);
+            const __m128 fire = _mm_cmple_ps(c, zero);
+            const __m128 late = _mm_and_ps(fire, _mm_sub_ps(zero, c));
+            const __m128 w = _mm_sub_ps(one, late);
+            const __m128 re = _mm_add_ps(_mm_loadu_ps(acc_re + l), _mm_mul_ps(xr, w));
+            const __m128 im = _mm_add_ps(_mm_loadu_ps(acc_im + l), _mm_mul_ps(xi, w));
+            _mm_storeu_ps(countdown + l, _mm_add_ps(c, _mm_and_ps(fire, per)));
+            _mm_storeu_ps(acc_re + l, _mm_or_ps(_mm_and_ps(fire, _mm_mul_ps(xr, late)), _mm_andnot_ps(fire, re)));
+            _mm_storeu_ps(acc_im + l, _mm_or_ps(_mm_and_ps(fire, _mm_mul_ps(xi, late)), _mm_andnot_ps(fire, im)));
+
+            const int mask = _mm_movemask_ps(fire);
+            if (mask) {
+                alignas(16) float r[4], m[4];
+                _mm_store_ps(r, re);
+                _mm_store_ps(m, im);
+                dumps = emit_dumps(mask, l, static_cast<uint32_t>(i), r, m, chips, lane, when, dumps);
+            }
+        }
+    }
+    return dumps;
+}
+
+// f(0) ... f(N - 1) written out at compile time, so per-stage arrays of registers stay in registers
+template <int N, typename F>
+inline void unroll(F&& f) {
+    [&]<int... S>(std::integer_sequence<int, S...>) { (f(S), ...); }(std::make_integer_sequence<int, N>{});
+}
+
+// I and Q of one stage share a register, the stages stay in registers for the whole block.
+// Bytes are widened a chunk at a time ahead of the integrators, which then only load and add
+template <int N>
+size_t cic_u8_sse2_n(const uint8_t* iq, size_t n, uint32_t* integ, uint32_t* comb, int decim,
+                     int* phase, float scale, cf32* out) {
+    constexpr size_t kChunk = 256;
+    __m128i acc[N], dly[N];
+    for (int s = 0; s < N; s++) {
+        acc[s] = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(integ + 2*s));
+        dly[s] = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(comb + 2*s));
+    }
+    const __m128i zero = _mm_setzero_si128(), bias = _mm_set1_epi32(255);
+    const __m128 sc = _mm_set1_ps(scale);
+    alignas(16) uint32_t x[2 * kChunk];
+    int ph = *phase;
+    size_t produced = 0;
+
+    for (size_t base = 0; base < n; base += kChunk) {
+        const size_t m = std::min(kChunk, n - base);
+        const uint8_t* in = iq + 2 * base;
+        size_t j = 0;
+        for (; j + 8 <= m; j += 8) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2*j));
+            const __m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+            const __m128i w[4] = {_mm_unpacklo_epi16(lo, zero), _mm_unpackhi_epi16(lo, zero),
+                                  _mm_unpacklo_epi16(hi, zero), _mm_unpackhi_epi16(hi, zero)};
+            for (int k = 0; k < 4; k++) {
+                _mm_store_si128(reinterpret_cast<__m128i*>(x + 2*j + 4*k), _mm_sub_epi32(_mm_slli_epi32(w[k], 1), bias));
+            }
+        }
+        for (; j < m; j++) {
+            x[2*j] = 2u * in[2*j] - 255u;
+            x[2*j + 1] = 2u * in[2*j + 1] - 255u;
+        }
+
+        for (j = 0; j < m; j++) {
+            __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(x + 2*j));
+            unroll<N>([&](int s) { v = acc[s] = _mm_add_epi32(acc[s], v); });
+            if (++ph < decim) continue;
+            ph = 0;
+            unroll<N>([&](int s) {
+                const __m128i d = _mm_sub_epi32(v, dly[s]);
+                dly[s] = v;
+                v = d;
+            });
+            _mm_storel_pi(reinterpret_cast<__m64*>(out + produced++), _mm_mul_ps(_mm_cvtepi32_ps(v), sc));
+        }
+    }
+
+    for (int s = 0; s < N; s++) {
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(integ + 2*s), acc[s]);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(comb + 2*s), dly[s]);
+    }
+    *phase = ph;
+    return produced;
+}
+
+size_t cic_u8_sse2(const uint8_t* iq, size_t n, uint32_t* integ, uint32_t* comb, int order, int decim,
+                   int* phase, float scale, cf32* out) {
+    switch (order) {
+        case 1: return cic_u8_sse2_n<1>(iq, n, integ, comb, decim, phase, scale, out);
+        case 2: return cic_u8_sse2_n<2>(iq, n, integ, comb, decim, phase, scale, out);
+        case 3: return cic_u8_sse2_n<3>(iq, n, integ, comb, decim, phase, scale, out);
+        case 4: return cic_u8_sse2_n<4>(iq, n, integ, comb, decim, phase, scale, out);
+        case 5: return cic_u8_sse2_n<5>(iq, n, integ, comb, decim, phase, scale, out);
+        case 6: return cic_u8_sse2_n<6>(iq, n, integ, comb, decim, phase, scale, out);
+        case 7: return cic_u8_sse2_n<7>(iq, n, integ, comb, decim, phase, scale, out);
+        case 8: return cic_u8_sse2_n<8>(iq, n, integ, comb, decim, phase, scale, out);
+        default: return cic_u8_scalar(iq, n, integ, comb, order, decim, phase, scale, out);
+    }
+}
+
+////////////////////////////////////////////////////////
+// AVX2 + FMA kernels
+////////////////////////////////////////////////////////
+
+SIMD_TARGET_AVX2 inline float hsum256(__m256 v) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+SIMD_TARGET_AVX2 inline cf32 csum256(__m256 v) {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    alignas(16) float f[4];
+    _mm_store_ps(f, s);
+    return {f[0], f[1]};
+}
+
+SIMD_TARGET_AVX2 inline __m256 reverse256(__m256 v) {
+    return _mm256_permutevar8x32_ps(v, _mm256_set_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+SIMD_TARGET_AVX2 inline __m256 creverse256(__m256 v) {
+    return _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(v), _MM_SHUFFLE(0, 1, 2, 3)));
+}
+
+// [h0 h1 h2 h3] -> [h0 h0 h1 h1 h2 h2 h3 h3]
+SIMD_TARGET_AVX2 inline __m256 dup_taps256(const float* h) {
+    return _mm256_permutevar8x32_ps(_mm256_castps128_ps256(_mm_loadu_ps(h)), _mm256_set_epi32(3, 3, 2, 2, 1, 1, 0, 0));
+}
+
+SIMD_TARGET_AVX2 float dot_f32_avx2(const float* x, const float* h, size_t n) {
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + k), _mm256_loadu_ps(h + k), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + k + 8), _mm256_loadu_ps(h + k + 8), acc1);
+    }
+    for (; k + 8 <= n; k += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + k), _mm256_loadu_ps(h + k), acc0);
+    }
+    float acc = hsum256(_mm256_add_ps(acc0, acc1));
+    for (; k < n; k++) acc += x[k] * h[k];
+    return acc;
+}
+
+SIMD_TARGET_AVX2 cf32 dot_cf32_avx2(const cf32* x, const float* h, size_t n) {
+    const float* xf = reinterpret_cast<const float*>(x);
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    size_t k = 0;
+    for (; k + 8 <= n; k += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(xf + 2*k), dup_taps256(h + k), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(xf + 2*k + 8), dup_taps256(h + k + 4), acc1);
+    }
+    cf32 acc = csum256(_mm256_add_ps(acc0, acc1));
+    cf32 tail = dot_cf32_scalar(x + k, h + k, n - k);
+    return {acc.real() + tail.real(), acc.imag() + tail.imag()};
+}
+
+SIMD_TARGET_AVX2 float dot_sym_f32_avx2(const float* w, const float* h, size_t n) {
+    const size_t half = n / 2;
+    __m256 acc = _mm256_setzero_ps();
+    size_t k = 0;
+    for (; k + 8 <= half; k += 8) {
+        __m256 s = _mm256_add_ps(_mm256_loadu_ps(w + k), reverse256(_mm256_loadu_ps(w + n - 8 - k)));
+        acc = _mm256_fmadd_ps(s, _mm256_loadu_ps(h + k), acc);
+    }
+    float sum = hsum256(acc);
+    for (; k < half; k++) sum += (w[k] + w[n - 1 - k]) * h[k];
+    if (n & 1) sum += w[half] * h[half];
+    return sum;
+}
+
+SIMD_TARGET_AVX2 cf32 dot_sym_cf32_avx2(const cf32* w, const float* h, size_t n) {
+    const float* wf = reinterpret_cast<const float*>(w);
+    const size_t half = n / 2;
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    size_t k = 0;
+    for (; k + 8 <= half; k += 8) {
+        __m256 s0 = _mm256_add_ps(_mm256_loadu_ps(wf + 2*k), creverse256(_mm256_loadu_ps(wf + 2*(n - 4 - k))));
+        __m256 s1 = _mm256_add_ps(_mm256_loadu_ps(wf + 2*k + 8), creverse256(_mm256_loadu_ps(wf + 2*(n - 8 - k))));
+        acc0 = _mm256_fmadd_ps(s0, dup_taps256(h + k), acc0);
+        acc1 = _mm256_fmadd_ps(s1, dup_taps256(h + k + 4), acc1);
+    }
+    cf32 acc = csum256(_mm256_add_ps(acc0, acc1));
+    float re = acc.real(), im = acc.imag();
+    for (; k < half; k++) {
+        re += (wf[2*k] + wf[2*(n - 1 - k)]) * h[k];
+        im += (wf[2*k + 1] + wf[2*(n - 1 - k) + 1]) * h[k];
+    }
+    if (n & 1) {
+        re += wf[2*half] * h[half];
+        im += wf[2*half + 1] * h[half];
+    }
+    return {re, im};
+}
+
+SIMD_TARGET_AVX2 void cmul_avx2(const cf32* a, const cf32* b, cf32* out, size_t n) {
+    const float* af = reinterpret_cast<const float*>(a);
+    const float* bf = reinterpret_cast<const float*>(b);
+    float* of = reinterpret_cast<float*>(out);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256 va = _mm256_loadu_ps(af + 2*i);
+        __m256 vb = _mm256_loadu_ps(bf + 2*i);
+        __m256 b_re = _mm256_moveldup_ps(vb);
+        __m256 b_im = _mm256_movehdup_ps(vb);
+        __m256 a_sw = _mm256_permute_ps(va, _MM_SHUFFLE(2, 3, 0, 1));
+        // even lanes: ar*br - ai*bi, odd lanes: ai*br + ar*bi
+        _mm256_storeu_ps(of + 2*i, _mm256_fmaddsub_ps(va, b_re, _mm256_mul_ps(a_sw, b_im)));
+    }
+    cmul_scalar(a + i, b + i, out + i, n - i);
+}
+
+SIMD_TARGET_AVX2 void mag2_avx2(const cf32* x, float* out, size_t n) {
+    const float* xf = reinterpret_cast<const float*>(x);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v0 = _mm256_loadu_ps(xf + 2*i);
+        __m256 v1 = _mm256_loadu_ps(xf + 2*i + 8);
+        v0 = _mm256_mul_ps(v0, v0);
+        v1 = _mm256_mul_ps(v1, v1);
+        __m256 s = _mm256_add_ps(_mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0)),
+                                 _mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1)));
+        // shuffle works per 128-bit lane, restore sample order
+        s = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(s), _MM_SHUFFLE(3, 1, 2, 0)));
+        _mm256_storeu_ps(out + i, s);
+    }
+    mag2_scalar(x + i, out + i, n - i);
+}
+
+SIMD_TARGET_AVX2 void f32_to_s16_avx2(const float* in, int16_t* out, size_t n, float scale) {
+    const __m256 lo = _mm256_set1_ps(-1.0f), hi = _mm256_set1_ps(1.0f), s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256 a = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i), lo), hi), s);
+        __m256 b = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i + 8), lo), hi), s);
+        __m256i packed = _mm256_packs_epi32(_mm256_cvtps_epi32(a), _mm256_cvtps_epi32(b));
+        packed = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+    f32_to_s16_scalar(in + i, out + i, n - i, scale);
+}
+
+SIMD_TARGET_AVX2 void s16_to_f32_avx2(const int16_t* in, float* out, size_t n, float scale) {
+    const __m256 s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), s));
+    }
+    s16_to_f32_scalar(in + i, out + i, n - i, scale);
+}
+
+SIMD_TARGET_AVX2 void u8_to_f32_avx2(const uint8_t* in, float* out, size_t n, float offset, float scale) {
+    const __m256 o = _mm256_set1_ps(offset), s = _mm256_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v));
+        __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_unpackhi_epi64(v, v)));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_add_ps(lo, o), s));
+        _mm256_storeu_ps(out + i + 8, _mm256_mul_ps(_mm256_add_ps(hi, o), s));
+    }
+    u8_to_f32_scalar(in + i, out + i, n - i, offset, scale);
+}
+
+SIMD_TARGET_AVX2 void atan2_f32_avx2(const float* y, const float* x, float* out, size_t n) {
+    const __m256 sign = _mm256_set1_ps(-0.0f), zero = _mm256_setzero_ps();
+    const __m256 pi = _mm256_set1_ps(kPi), half_pi = _mm256_set1_ps(kHalfPi);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        const __m256 vy = _mm256_loadu_ps(y + i), vx = _mm256_loadu_ps(x + i);
+        const __m256 ax = _mm256_andnot_ps(sign, vx), ay = _mm256_andnot_ps(sign, vy);
+        const __m256 mx = _mm256_max_ps(ax, ay), mn = _mm256_min_ps(ax, ay);
+        const __m256 z = _mm256_and_ps(_mm256_div_ps(mn, mx), _mm256_cmp_ps(mx, zero, _CMP_GT_OQ));
+        const __m256 z2 = _mm256_mul_ps(z, z);
+        __m256 p = _mm256_set1_ps(kAtanC[5]);
+        for (int k = 4; k >= 0; k--) p = _mm256_fmadd_ps(p, z2, _mm256_set1_ps(kAtanC[k]));
+        __m256 r = _mm256_mul_ps(z, p);
+
+        r = _mm256_blendv_ps(r, _mm256_sub_ps(half_pi, r), _mm256_cmp_ps(ay, ax, _CMP_GT_OQ));
+        r = _mm256_blendv_ps(r, _mm256_sub_ps(pi, r), vx);     // blend on the sign bit of x
+        _mm256_storeu_ps(out + i, _mm256_or_ps(r, _mm256_and_ps(vy, sign)));
+    }
+    atan2_f32_scalar(y + i, x + i, out + i, n - i);
+}
+
+SIMD_TARGET_AVX2 size_t dump_clocks_avx2(const cf32* x, size_t n, float* countdown, float* acc_re, float* acc_im,
+                                         size_t lanes, float period, cf32* chips, uint16_t* lane, uint32_t* when) {
+    if (lanes % 8) return dump_clocks_sse2(x, n, countdown, acc_re, acc_im, lanes, period, chips, lane, when);
+    const __m256 one = _mm256_set1_ps(1.0f), zero = _mm256_setzero_ps(), per = _mm256_set1_ps(period);
+    size_t dumps = 0;
+    for (size_t i = 0; i < n; i++) {
+        const __m256 xr = _mm256_set1_ps(x[i].real()), xi = _mm256_set1_ps(x[i].imag());
+        for (size_t l = 0; l < lanes; l += 8) {
+            const __m256 c = _mm256_sub_ps(_mm256_loadu_ps(countdown + l), one);
+            const __m256 fire = _mm256_cmp_ps(c, zero, _CMP_LE_OQ);
+            const __m256 late = _mm256_and_ps(fire, _mm256_sub_ps(zero, c));
+            const __m256 w = _mm256_sub_ps(one, late);
+            const __m256 re = _mm256_add_ps(_mm256_loadu_ps(acc_re + l), _mm256_mul_ps(xr, w));
+            const __m256 im = _mm256_add_ps(_mm256_loadu_ps(acc_im + l), _mm256_mul_ps(xi, w));
+            _mm256_storeu_ps(countdown + l, _mm256_add_ps(c, _mm256_and_ps(fire, per)));
+            _mm256_storeu_ps(acc_re + l, _mm256_blendv_ps(re, _mm256_mul_ps(xr, late), fire));
+            _mm256_storeu_ps(acc_im + l, _mm256_blendv_ps(im, _mm256_mul_ps(xi, late), fire));
+
+            const int mask = _mm256_movemask_ps(fire);
+            if (mask) {
+                alignas(32) float r[8], m[8];
+                _mm256_store_ps(r, re);
+                _mm256_store_ps(m, im);
+                dumps = emit_dumps(mask, l, static_cast<uint32_t>(i), r, m, chips, lane, when, dumps);
+            }
+        }
+    }
+    return dumps;
+}
+
+////////////////////////////////////////////////////////
+// AVX-512F kernels
+////////////////////////////////////////////////////////
+
+SIMD_TARGET_AVX512 inline cf32 csum512(__m512 v) {
+    alignas(64) float f[16];
+    _mm512_store_ps(f, v);
+    float re = 0.0f, im = 0.0f;
+    for (int j = 0; j < 16; j += 2) {
+        re += f[j];
+        im += f[j + 1];
+    }
+    return {re, im};
+}
+
+SIMD_TARGET_AVX512 inline __m512 reverse512(__m512 v) {
+    return _mm512_permutexvar_ps(_mm512_set_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), v);
+}
+
+SIMD_TARGET_AVX512 inline __m512 creverse512(__m512 v) {
+    return _mm512_permutexvar_ps(_mm512_set_epi32(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14), v);
+}
+
+// [h0 .. h7] -> [h0 h0 h1 h1 .. h7 h7]
+SIMD_TARGET_AVX512 inline __m512 dup_taps512(const float* h) {
+    return _mm512_permutexvar_ps(_mm512_set_epi32(7, 7, 6, 6, 5, 5, 4, 4, 3, 3, 2, 2, 1, 1, 0, 0),
+                                 _mm512_castps256_ps512(_mm256_loadu_ps(h)));
+}
+
+SIMD_TARGET_AVX512 float dot_f32_avx512(const float* x, const float* h, size_t n) {
+    __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+    size_t k = 0;
+    for (; k + 32 <= n; k += 32) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + k), _mm512_loadu_ps(h + k), acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + k + 16), _mm512_loadu_ps(h + k + 16), acc1);
+    }
+    if (k + 16 <= n) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + k), _mm512_loadu_ps(h + k), acc0);
+        k += 16;
+    }
+    if (k < n) {
+        const __mmask16 m = (__mmask16)((1u << (n - k)) - 1);
+        acc1 = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(m, x + k), _mm512_maskz_loadu_ps(m, h + k), acc1);
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(acc0, acc1));
+}
+
+SIMD_TARGET_AVX512 cf32 dot_cf32_avx512(const cf32* x, const float* h, size_t n) {
+    const float* xf = reinterpret_cast<const float*>(x);
+    __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+    size_t k = 0;
+    for (; k + 16 <= n; k += 16) {
+        acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(xf + 2*k), dup_taps512(h + k), acc0);
+        acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(xf + 2*k + 16), dup_taps512(h + k + 8), acc1);
+    }
+    cf32 acc = csum512(_mm512_add_ps(acc0, acc1));
+    cf32 tail = dot_cf32_avx2(x + k, h + k, n - k);
+    return {acc.real() + tail.real(), acc.imag() + tail.imag()};
+}
+
+SIMD_TARGET_AVX512 float dot_sym_f32_avx512(const float* w, const float* h, size_t n) {
+    const size_t half = n / 2;
+    __m512 acc = _mm512_setzero_ps();
+    size_t k = 0;
+    for (; k + 16 <= half; k += 16) {
+        __m512 s = _mm512_add_ps(_mm512_loadu_ps(w + k), reverse512(_mm512_loadu_ps(w + n - 16 - k)));
+        acc = _mm512_fmadd_ps(s, _mm512_loadu_ps(h + k), acc);
+    }
+    float sum = _mm512_reduce_add_ps(acc);
+    for (; k < half; k++) sum += (w[k] + w[n - 1 - k]) * h[k];
+    if (n & 1) sum += w[half] * h[half];
+    return sum;
+}
+
+SIMD_TARGET_AVX512 cf32 dot_sym_cf32_avx512(const cf32* w, const float* h, size_t n) {
+    const float* wf = reinterpret_cast<const float*>(w);
+    const size_t half = n / 2;
+    __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+    size_t k = 0;
+    for (; k + 16 <= half; k += 16) {
+        __m512 s0 = _mm512_add_ps(_mm512_loadu_ps(wf + 2*k), creverse512(_mm512_loadu_ps(wf + 2*(n - 8 - k))));
+        __m512 s1 = _mm512_add_ps(_mm512_loadu_ps(wf + 2*k + 16), creverse512(_mm512_loadu_ps(wf + 2*(n - 16 - k))));
+        acc0 = _mm512_fmadd_ps(s0, dup_taps512(h + k), acc0);
+        acc1 = _mm512_fmadd_ps(s1, dup_taps512(h + k + 8), acc1);
+    }
+    cf32 acc = csum512(_mm512_add_ps(acc0, acc1));
+    float re = acc.real(), im = acc.imag();
+    for (; k < half; k++) {
+        re += (wf[2*k] + wf[2*(n - 1 - k)]) * h[k];
+        im += (wf[2*k + 1] + wf[2*(n - 1 - k) + 1]) * h[k];
+    }
+    if (n & 1) {
+        re += wf[2*half] * h[half];
+        im += wf[2*half + 1] * h[half];
+    }
+    return {re, im};
+}
+
+SIMD_TARGET_AVX512 void cmul_avx512(const cf32* a, const cf32* b, cf32* out, size_t n) {
+    const float* af = reinterpret_cast<const float*>(a);
+    const float* bf = reinterpret_cast<const float*>(b);
+    float* of = reinterpret_cast<float*>(out);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512 va = _mm512_loadu_ps(af + 2*i);
+        __m512 vb = _mm512_loadu_ps(bf + 2*i);
+        __m512 b_re = _mm512_moveldup_ps(vb);
+        __m512 b_im = _mm512_movehdup_ps(vb);
+        __m512 a_sw = _mm512_permute_ps(va, _MM_SHUFFLE(2, 3, 0, 1));
+        _mm512_storeu_ps(of + 2*i, _mm512_fmaddsub_ps(va, b_re, _mm512_mul_ps(a_sw, b_im)));
+    }
+    cmul_avx2(a + i, b + i, out + i, n - i);
+}
+
+SIMD_TARGET_AVX512 void mag2_avx512(const cf32* x, float* out, size_t n) {
+    const float* xf = reinterpret_cast<const float*>(x);
+    const __m512i even = _mm512_set_epi32(30, 28, 26, 24, 22, 20, 18, 16, 14, 12, 10, 8, 6, 4, 2, 0);
+    const __m512i odd = _mm512_set_epi32(31, 29, 27, 25, 23, 21, 19, 17, 15, 13, 11, 9, 7, 5, 3, 1);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 v0 = _mm512_loadu_ps(xf + 2*i);
+        __m512 v1 = _mm512_loadu_ps(xf + 2*i + 16);
+        __m512 re = _mm512_permutex2var_ps(v0, even, v1);
+        __m512 im = _mm512_permutex2var_ps(v0, odd, v1);
+        _mm512_storeu_ps(out + i, _mm512_fmadd_ps(re, re, _mm512_mul_ps(im, im)));
+    }
+    mag2_avx2(x + i, out + i, n - i);
+}
+
+SIMD_TARGET_AVX512 void f32_to_s16_avx512(const float* in, int16_t* out, size_t n, float scale) {
+    const __m512 lo = _mm512_set1_ps(-1.0f), hi = _mm512_set1_ps(1.0f), s = _mm512_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 a = _mm512_mul_ps(_mm512_min_ps(_mm512_max_ps(_mm512_loadu_ps(in + i), lo), hi), s);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm512_cvtsepi32_epi16(_mm512_cvtps_epi32(a)));
+    }
+    f32_to_s16_avx2(in + i, out + i, n - i, scale);
+}
+
+SIMD_TARGET_AVX512 void s16_to_f32_avx512(const int16_t* in, float* out, size_t n, float scale) {
+    const __m512 s = _mm512_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i v = _mm512_cvtepi16_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i)));
+        _mm512_storeu_ps(out + i, _mm512_mul_ps(_mm512_cvtepi32_ps(v), s));
+    }
+    s16_to_f32_avx2(in + i, out + i, n - i, scale);
+}
+
+SIMD_TARGET_AVX512 void u8_to_f32_avx512(const uint8_t* in, float* out, size_t n, float offset, float scale) {
+    const __m512 o = _mm512_set1_ps(offset), s = _mm512_set1_ps(scale);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512 v = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))));
+        _mm512_storeu_ps(out + i, _mm512_mul_ps(_mm512_add_ps(v, o), s));
+    }
+    u8_to_f32_scalar(in + i, out + i, n - i, offset, scale);
+}
+
+SIMD_TARGET_AVX512 void atan2_f32_avx512(const float* y, const float* x, float* out, size_t n) {
+    const __m512i sign = _mm512_set1_epi32((int)0x80000000);
+    const __m512 pi = _mm512_set1_ps(kPi), half_pi = _mm512_set1_ps(kHalfPi);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m512 vy = _mm512_loadu_ps(y + i), vx = _mm512_loadu_ps(x + i);
+        const __m512 ax = _mm512_abs_ps(vx), ay = _mm512_abs_ps(vy);
+        const __m512 mx = _mm512_max_ps(ax, ay), mn = _mm512_min_ps(ax, ay);
+        const __mmask16 nz = _mm512_cmp_ps_mask(mx, _mm512_setzero_ps(), _CMP_GT_OQ);
+        const __m512 z = _mm512_maskz_div_ps(nz, mn, mx);
+        const __m512 z2 = _mm512_mul_ps(z, z);
+        __m512 p = _mm512_set1_ps(kAtanC[5]);
+        for (int k = 4; k >= 0; k--) p = _mm512_fmadd_ps(p, z2, _mm512_set1_ps(kAtanC[k]));
+        __m512 r = _mm512_mul_ps(z, p);
+
+        r = _mm512_mask_sub_ps(r, _mm512_cmp_ps_mask(ay, ax, _CMP_GT_OQ), half_pi, r);
+        r = _mm512_mask_sub_ps(r, _mm512_test_epi32_mask(_mm512_castps_si512(vx), sign), pi, r);
+        const __m512i ysign = _mm512_and_epi32(_mm512_castps_si512(vy), sign);
+        _mm512_storeu_ps(out + i, _mm512_castsi512_ps(_mm512_or_epi32(_mm512_castps_si512(r), ysign)));
+    }
+    atan2_f32_avx2(y + i, x + i, out + i, n - i);
+}
+
+SIMD_TARGET_AVX512 size_t dump_clocks_avx512(const cf32* x, size_t n, float* countdown, float* acc_re, float* acc_im,
+                                             size_t lanes, float period, cf32* chips, uint16_t* lane, uint32_t* when) {
+    if (lanes % 16) return dump_clocks_avx2(x, n, countdown, acc_re, acc_im, lanes, period, chips, lane, when);
+    const __m512 one = _mm512_set1_ps(1.0f), zero = _mm512_setzero_ps(), per = _mm512_set1_ps(period);
+    size_t dumps = 0;
+    for (size_t i = 0; i < n; i++) {
+        const __m512 xr = _mm512_set1_ps(x[i].real()), xi = _mm512_set1_ps(x[i].imag());
+        for (size_t l = 0; l < lanes; l += 16) {
+            const __m512 c = _mm512_sub_ps(_mm512_loadu_ps(countdown + l), one);
+            const __mmask16 fire = _mm512_cmp_ps_mask(c, zero, _CMP_LE_OQ);
+            const __m512 late = _mm512_maskz_sub_ps(fire, zero, c);
+            const __m512 w = _mm512_sub_ps(one, late);
+            const __m512 re = _mm512_add_ps(_mm512_loadu_ps(acc_re + l), _mm512_mul_ps(xr, w));
+            const __m512 im = _mm512_add_ps(_mm512_loadu_ps(acc_im + l), _mm512_mul_ps(xi, w));
+            _mm512_storeu_ps(countdown + l, _mm512_mask_add_ps(c, fire, c, per));
+            _mm512_storeu_ps(acc_re + l, _mm512_mask_mul_ps(re, fire, xr, late));
+            _mm512_storeu_ps(acc_im + l, _mm512_mask_mul_ps(im, fire, xi, late));
+
+            if (fire) {
+                alignas(64) float r[16], m[16];
+                _mm512_store_ps(r, re);
+                _mm512_store_ps(m, im);
+                dumps = emit_dumps(fire, l, static_cast<uint32_t>(i), r, m, chips, lane, when, dumps);
+            }
+        }
+    }
+    return dumps;
+}
+
+////////////////////////////////////////////////////////
+// CPU feature detection
+////////////////////////////////////////////////////////
+
+struct CpuFeatures {
+    bool sse2 = false;
+    bool avx2 = false;
+    bool avx512 = false;
+};
+
+CpuFeatures detect_cpu() {
+    CpuFeatures f;
+#if defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 0);
+    const int max_leaf = regs[0];
+
+    __cpuid(regs, 1);
+    f.sse2 = (regs[3] & (1 << 26)) != 0;
+    const bool fma = (regs[2] & (1 << 12)) != 0;
+    const bool osxsave = (regs[2] & (1 << 27)) != 0;
+
+    // OS must save YMM (and ZMM/opmask) state on context switches
+    const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+    const bool os_avx = (xcr0 & 0x6) == 0x6;
+    const bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+
+    if (max_leaf >= 7) {
+        __cpuidex(regs, 7, 0);
+        f.avx2 = os_avx && fma && (regs[1] & (1 << 5)) != 0;
+        f.avx512 = os_avx512 && (regs[1] & (1 << 16)) != 0;
+    }
+#else
+    // libgcc checks OS (XSAVE) support together with the CPUID bits
+    __builtin_cpu_init();
+    f.sse2 = __builtin_cpu_supports("sse2");
+    f.avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    f.avx512 = __builtin_cpu_supports("avx512f");
+#endif
+    return f;
+}
+
+#endif // SIMD_X86
+
+const KernelTable kScalar{
+    Isa::Scalar,
+    dot_f32_scalar, dot_cf32_scalar, dot_sym_f32_scalar, dot_sym_cf32_scalar,
+    cmul_scalar, mag2_scalar, f32_to_s16_scalar, s16_to_f32_scalar, u8_to_f32_scalar,
+    atan2_f32_scalar, dump_clocks_scalar, cic_u8_scalar
+};
+
+#if SIMD_X86
+const KernelTable kSSE2{
+    Isa::SSE2,
+    dot_f32_sse2, dot_cf32_sse2, dot_sym_f32_sse2, dot_sym_cf32_sse2,
+    cmul_sse2, mag2_sse2, f32_to_s16_sse2, s16_to_f32_sse2, u8_to_f32_sse2,
+    atan2_f32_sse2, dump_clocks_sse2, cic_u8_sse2
+};
+
+const KernelTable kAVX2{
+    Isa::AVX2,
+    dot_f32_avx2, dot_cf32_avx2, dot_sym_f32_avx2, dot_sym_cf32_avx2,
+    cmul_avx2, mag2_avx2, f32_to_s16_avx2, s16_to_f32_avx2, u8_to_f32_avx2,
+    atan2_f32_avx2, dump_clocks_avx2,
+    cic_u8_sse2     // integrators are serial in time and two lanes wide, wider registers add nothing
+};
+
+const KernelTable kAVX512{
+    Isa::AVX512,
+    dot_f32_avx512, dot_cf32_avx512, dot_sym_f32_avx512, dot_sym_cf32_avx512,
+    cmul_avx512, mag2_avx512, f32_to_s16_avx512, s16_to_f32_avx512, u8_to_f32_avx512,
+    atan2_f32_avx512, dump_clocks_avx512,
+    cic_u8_sse2
+};
+#endif
+
+// Optional cap from the environment, useful to compare kernels on one machine
+Isa isa_limit() {
+    const char* env = std::getenv("FM_SIMD");
+    if (!env) return Isa::AVX512;
+
+    const std::string v(env);
+    if (v == "scalar") return Isa::Scalar;
+    if (v == "sse2") return Isa::SSE2;
+    if (v == "avx2") return Isa::AVX2;
+    return Isa::AVX512;
+}
+
+const KernelTable& select_kernels() {
+    const Isa limit = isa_limit();
+    for (Isa isa : {Isa::AVX512, Isa::AVX2, Isa::SSE2}) {
+        const KernelTable* k = kernels_for(isa);
+        if (k && isa <= limit) return *k;
+    }
+    return kScalar;
+}
+
+}
+
+const KernelTable& kernels() {
+    static const KernelTable& selected = select_kernels();
+    return selected;
+}
+
+const KernelTable* kernels_for(Isa isa) {
+    if (isa == Isa::Scalar) return &kScalar;
+#if SIMD_X86
+    static const CpuFeatures cpu = detect_cpu();
+    if (isa == Isa::SSE2 && cpu.sse2) return &kSSE2;
+    if (isa == Isa::AVX2 && cpu.avx2) return &kAVX2;
+    if (isa == Isa::AVX512 && cpu.avx512 && cpu.avx2) return &kAVX512;
+#endif
+    return nullptr;
+}
+
+const char* isa_name(Isa isa) {
+    switch (isa) {
+        case Isa::SSE2: return "SSE2";
+        case Isa::AVX2: return "AVX2+FMA";
+        case Isa::AVX512: return "AVX-512F";
+        default: return "scalar";
+    }
+}
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <complex>
+#include <cmath>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// Vectorized DSP kernels with runtime CPU feature dispatch.
+// Every ISA variant is compiled into the binary and the best one supported by the
+// running CPU is selected on first use, so one build runs on any x86-64 machine.
+// Complex math is written out explicitly (no std::complex operator*), so results
+// do not depend on the compiler's NaN/Inf recovery paths or fast-math settings.
+namespace simd {
+
+enum class Isa {
+    Scalar,
+    SSE2,
+    AVX2,       // AVX2 + FMA
+    AVX512      // AVX-512F
+};
+
+struct KernelTable {
+    Isa isa;
+
+    // sum h[k] * x[k]
+    float (*dot_f32)(const float* x, const float* h, size_t n);
+    // sum h[k] * x[k] for complex samples and real taps
+    std::complex<float> (*dot_cf32)(const std::complex<float>* x, const float* h, size_t n);
+    // Folded dot product for symmetric taps: sum h[k] * (w[k] + w[n-1-k]) over the first half
+    float (*dot_sym_f32)(const float* w, const float* h, size_t n);
+    std::complex<float> (*dot_sym_cf32)(const std::complex<float>* w, const float* h, size_t n);
+
+    // out[i] = a[i] * b[i]
+    void (*cmul)(const std::complex<float>* a, const std::complex<float>* b, std::complex<float>* out, size_t n);
+    // out[i] = |x[i]|^2
+    void (*mag2)(const std::complex<float>* x, float* out, size_t n);
+
+    // out[i] = round(clamp(in[i], -1, 1) * scale)
+    void (*f32_to_s16)(const float* in, int16_t* out, size_t n, float scale);
+    // out[i] = in[i] * scale
+    void (*s16_to_f32)(const int16_t* in, float* out, size_t n, float scale);
+    // out[i] = (in[i] + offset) * scale, raw RTL-SDR bytes to float
+    void (*u8_to_f32)(const uint8_t* in, float* out, size_t n, float offset, float scale);
+
+    // out[i] ~= atan2(y[i], x[i]), polynomial approximation, |error| < 2e-6 rad
+    void (*atan2_f32)(const float* y, const float* x, float* out, size_t n);
+
+    // Integrate-and-dump clocks, one per lane (structure of arrays). Every sample counts each lane's
+    // countdown down by one and adds x to its sum; a lane reaching zero dumps its sum, with the sample
+    // that crosses the boundary split by the fractional position, and adds period to the countdown.
+    // Dumps go to chips / lane / when in sample then lane order, returns their count
+    size_t (*dump_clocks)(const std::complex<float>* x, size_t n, float* countdown, float* acc_re, float* acc_im,
+                          size_t lanes, float period, std::complex<float>* chips, uint16_t* lane, uint32_t* when);
+
+    // CIC decimation of n interleaved I/Q byte pairs, order integrator / comb pairs in wrapping 32-bit
+    // arithmetic on (b - 127.5) * 2. integ and comb hold the states as [I0 Q0 I1 Q1 ...], phase counts
+    // the inputs since the last output. Outputs are scaled by scale, returns their count
+    size_t (*cic_u8)(const uint8_t* iq, size_t n, uint32_t* integ, uint32_t* comb, int order, int decim,
+                     int* phase, float scale, std::complex<float>* out);
+};
+
+// atan(z) on [0, 1], 11th order minimax polynomial, |error| < 2e-6 rad, used by every atan2_f32 variant
+inline constexpr float kAtanC[6] = {0.99997726f, -0.33262347f, 0.19354346f, -0.11643287f, 0.05265332f, -0.01172120f};
+inline constexpr float kPi = 3.14159265358979f;
+inline constexpr float kHalfPi = 1.57079632679490f;
+
+// One sample of atan2_f32 inline, per-sample callers skip the dispatch and the vector tail handling
+inline float atan2_poly(float y, float x) {
+    const float ax = std::abs(x), ay = std::abs(y);
+    const float mx = std::max(ax, ay), mn = std::min(ax, ay);
+    const float z = mx > 0.0f ? mn / mx : 0.0f;
+    const float z2 = z * z;
+    float p = kAtanC[5];
+    for (int k = 4; k >= 0; k--) p = p * z2 + kAtanC[k];
+    float r = z * p;
+    if (ay > ax) r = kHalfPi - r;           // octant fold
+    if (std::signbit(x)) r = kPi - r;       // left half plane
+    return std::copysign(r, y);
+}
+
+// Kernel table for the best ISA on this CPU (can be capped with FM_SIMD=scalar|sse2|avx2|avx512)
+const KernelTable& kernels();
+
+// Kernel table for a specific ISA, nullptr if the CPU or build does not support it
+const KernelTable* kernels_for(Isa isa);
+
+const char* isa_name(Isa isa);
+
+}
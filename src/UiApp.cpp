@@ -101,6 +101,9 @@ void UiApp::Run(const UiAppConfig& cfg, const SpectrumBuffer& rf_spec, const Wat
 
     static double last_freq = cfg.center_freq_hz;
 
+    // Latest RDS snapshot, copied again only when the decoder publishes a new version
+    RdsSnapshot rds{};
+
 
     while (!quit) {
         // Events
@@ -220,14 +223,24 @@ void UiApp::Run(const UiAppConfig& cfg, const SpectrumBuffer& rf_spec, const Wat
         ImGui::Text("FFT: %d", cfg.fft_size);
 
         if (cfg.rds_decoder) {
-            RdsSnapshot rds = cfg.rds_decoder->snapshot();
+            if (cfg.rds_decoder->version() != rds.version) {
+                rds = cfg.rds_decoder->snapshot();
+            }
 
             ImGui::Separator();
             ImGui::Text("RDS");
-            ImGui::Text("Lock: %s", rds.synced ? "Yes" : "No");
+            ImGui::Text("Lock: %s (%s timing)", rds.synced ? "Yes" : "No", rds.timing_bank ? "clock bank" : "single clock");
             ImGui::Text("PI: %s", rds.pi.empty() ? "--" : rds.pi.c_str());
             ImGui::Text("PS: %s", rds.program_service.empty() ? "--" : rds.program_service.c_str());
             ImGui::TextWrapped("RT: %s", rds.radio_text.empty() ? "--" : rds.radio_text.c_str());
+
+            ImGui::Separator();
+            ImGui::Text("Mode: %s (pilot %.1f dB)", rds.stereo ? "Stereo" : "Mono", rds.pilot_db);
+            if (rds.mono_saving >= 0.0f) {
+                ImGui::Text("Mono fast path: -%.0f%% CPU", rds.mono_saving * 100.0f);
+            } else {
+                ImGui::Text("Mono fast path: --");
+            }
         }
 
         // Gain control
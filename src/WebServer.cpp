@@ -1,4 +1,5 @@
 #include "WebServer.hpp"
+#include "SimdKernels.hpp"
 
 #include <algorithm>
 #include <cmath>
@@ -167,10 +168,7 @@ void WebSocketStreamer::publishAudioPcm16(const float* interleavedStereo, size_t
 
     auto* pcm = reinterpret_cast<int16_t*>(frame.data());
 
-    for (size_t i = 0; i < sampleCount; ++i) {
-        float x = std::clamp(interleavedStereo[i], -1.0f, 1.0f);
-        pcm[i] = static_cast<int16_t>(std::lrintf(x * 32767.0f));
-    }
+    simd::kernels().f32_to_s16(interleavedStereo, pcm, sampleCount, 32767.0f);
 
     loop_->defer([this, frame = std::move(frame)] {
         if (app_) {
@@ -1,21 +1,31 @@
 #include <iostream>
 #include <cstdint>
+#include <cstdlib>
 #include <atomic>
 #include <complex>
 #include <thread>
 #include <chrono>
 #include <atomic>
 #include <csignal>
+#include <cstdio>
+#include <string>
+#include <utility>
 #include <nlohmann/json.hpp>
 #include <rtl-sdr.h>
 #include <portaudio.h>
 #include "AudioFile.h"
 #include "FIRFilter.hpp"
+#include "IqFrontEnd.hpp"
+#include "Resampler.hpp"
+#include "DriftCompensator.hpp"
+#include "FFTFilter.hpp"
+#include "FilterDesign.hpp"
 #include "DSPBlocks.hpp"
 #include "CircularBuffer.hpp"
 #include "SpectrumBuffer.hpp"
 #include "WaterfallBuffer.hpp"
 #include "RfFFTAnalyzer.hpp"
+#include "SimdKernels.hpp"
 #include "RdsDecoder.hpp"
 #include "UiApp.hpp"
 #include "WebServer.hpp"
@@ -71,7 +81,7 @@ static int paCallback(const void* input, void* output,
     size_t read = ctx->ring->pop(out, samples_needed);               // read 'frameCount' samples
 
     if (read < samples_needed) {
-        std::fill(out + read, out + frameCount, 0.0f);      // If buffer empty, fill rest with silence
+        std::fill(out + read, out + samples_needed, 0.0f);  // If buffer empty, fill rest with silence
         g_underruns.fetch_add(1, std::memory_order_relaxed);
     }
 
@@ -111,6 +121,15 @@ int main(int argc, char* argv[]) {
     // Parse arguments
     bool live_stream = true;    // live stream by default
     bool record_mode = false;
+    bool multistage = false;    // CIC + half-band first stage instead of a single FIR
+    MultistagePlan::HalfBand halfband = MultistagePlan::HalfBand::Fir;     // multistage half-band stages
+    FmDemod::Mode demod_mode = FmDemod::Mode::FastAtan2;
+    uint32_t mpx_rate = 480'000;  // demodulation / pilot PLL / RDS rate, lower bound
+    uint32_t sample_rate = 2'400'000;   // dongle rate
+    uint32_t audio_rate = 48'000;       // PortAudio / WAV rate
+    bool drift_comp = true;             // pilot / ring fill clock drift compensation in live mode
+    bool low_latency = false;           // minimum phase audio LPF, small blocks and buffers
+    RdsDecoder::Timing rds_timing = RdsDecoder::Timing::Auto;      // RDS chip timing recovery
     std::ofstream raw_dump;
 
     for(int i=1; i<argc; i++) {
@@ -122,12 +141,36 @@ int main(int argc, char* argv[]) {
             std::cout << "  (default)   Enable live audio output (PortAudio)\n";
             std::cout << "  --save      Save 10s processed audio to 'stereo_out.wav' file\n";
             std::cout << "  --record    Record raw IQ samples to 'raw_iq_samples.bin'\n";
+            std::cout << "  --multistage  Use CIC + half-band multistage first stage decimator\n";
+            std::cout << "  --halfband=KIND  Multistage half-bands: fir (default), iir (all-pass, minimum delay), iir-linear\n";
+            std::cout << "  --demod=MODE  FM discriminator: atan2 (exact), fast (polynomial, default), quotient\n";
+            std::cout << "  --mpx-rate=N  Minimum demodulation rate in S/s, 480000 (default), at least 240000\n";
+            std::cout << "  --sample-rate=N  Dongle sample rate in S/s, 2400000 (default), 2048000, 1024000, ...\n";
+            std::cout << "  --audio-rate=N   Output audio rate in S/s, 48000 (default), 44100, 32000, 16000, ...\n";
+            std::cout << "  --no-drift  Disable dongle / sound card clock drift compensation\n";
+            std::cout << "  --low-latency  Minimum phase audio filter, small blocks, adaptive audio buffering\n";
+            std::cout << "  --rds-timing=MODE  RDS chip timing: auto (Gardner, clock bank on weak signals, default), gardner, bank\n";
             std::cout << "  -h, --help  Show this usage information\n";
             return 0;
         }
 
         if (std::strcmp(argv[i], "--record") == 0) record_mode = true;
         if (std::strcmp(argv[i], "--save") == 0) live_stream = false;       // save to .wav file
+        if (std::strcmp(argv[i], "--multistage") == 0) multistage = true;
+        if (std::strcmp(argv[i], "--halfband=fir") == 0) halfband = MultistagePlan::HalfBand::Fir;
+        if (std::strcmp(argv[i], "--halfband=iir") == 0) halfband = MultistagePlan::HalfBand::IirMinimumDelay;
+        if (std::strcmp(argv[i], "--halfband=iir-linear") == 0) halfband = MultistagePlan::HalfBand::IirNearLinear;
+        if (std::strcmp(argv[i], "--demod=atan2") == 0) demod_mode = FmDemod::Mode::Atan2;
+        if (std::strcmp(argv[i], "--demod=fast") == 0) demod_mode = FmDemod::Mode::FastAtan2;
+        if (std::strcmp(argv[i], "--demod=quotient") == 0) demod_mode = FmDemod::Mode::Quotient;
+        if (std::strncmp(argv[i], "--mpx-rate=", 11) == 0) mpx_rate = (uint32_t)std::strtoul(argv[i] + 11, nullptr, 10);
+        if (std::strncmp(argv[i], "--sample-rate=", 14) == 0) sample_rate = (uint32_t)std::strtoul(argv[i] + 14, nullptr, 10);
+        if (std::strcmp(argv[i], "--no-drift") == 0) drift_comp = false;
+        if (std::strcmp(argv[i], "--low-latency") == 0) low_latency = true;
+        if (std::strcmp(argv[i], "--rds-timing=auto") == 0) rds_timing = RdsDecoder::Timing::Auto;
+        if (std::strcmp(argv[i], "--rds-timing=gardner") == 0) rds_timing = RdsDecoder::Timing::Gardner;
+        if (std::strcmp(argv[i], "--rds-timing=bank") == 0) rds_timing = RdsDecoder::Timing::Bank;
+        if (std::strncmp(argv[i], "--audio-rate=", 13) == 0) audio_rate = (uint32_t)std::strtoul(argv[i] + 13, nullptr, 10);
     }
 
     // Record mode
@@ -156,12 +199,24 @@ int main(int argc, char* argv[]) {
     r = rtlsdr_open(&dev, 0);
     if (r != 0 || !dev) { std::cerr << "rtlsdr_open failed: " << r << "\n"; return 1; }
 
-    // Basic config
-    const uint32_t fs = 2'400'000;      // 2.4 MS/s
-    const uint32_t fc = 93'300'000;     // 93.3 MHz
-    const uint32_t fq = fs / 5;         // decimation after LPF to 480k
-    const uint32_t fa = fq / 10;        // decimation to 48k 
-    const float max_dev = 75'000.0f;    // max deviation for broadcast FM
+    // Basic config, decimation plan derived from the dongle, MPX and output rates
+    if (mpx_rate < 240'000 || audio_rate == 0) {
+        std::cerr << "Unsupported --mpx-rate " << mpx_rate << " / --audio-rate " << audio_rate << "\n";
+        return 1;
+    }
+    const RatePlan rate_plan = RatePlan::derive(sample_rate, mpx_rate, audio_rate);
+    const uint32_t fs = rate_plan.fs;               // 2.4 MS/s by default
+    const uint32_t fc = 93'300'000;                 // 93.3 MHz
+    const uint32_t fq = rate_plan.mpx_rate();       // decimation after LPF to 480k (512k for 2.048 MS/s)
+    const uint32_t fa = rate_plan.audio_rate();     // decimation to 48k (51.2k for 2.048 MS/s)
+    const uint32_t fo = audio_rate;                 // resampled output rate
+    const float max_dev = 75'000.0f;                // max deviation for broadcast FM
+
+    // Below 240k the discriminator runs out of headroom for 75kHz deviation plus the 57kHz RDS band
+    if (fq < 240'000) {
+        std::cerr << "No integer decimation of " << fs << " S/s reaches " << mpx_rate << " S/s\n";
+        return 1;
+    }
 
     // Thresholds for discriminator after demod
     const float dphi_max = 2.0f * 3.14159265f * (max_dev / fq);     // max change in phase
@@ -183,38 +238,78 @@ int main(int argc, char* argv[]) {
     // Reset buffers
     rtlsdr_reset_buffer(dev);
 
+    // Report which vector instruction set the DSP kernels dispatched to
+    std::cout << "DSP kernels: " << simd::isa_name(simd::kernels().isa) << "\n";
+
     ////////////////////////////////////////////////////////
     // DSP Pipeline start
     ////////////////////////////////////////////////////////
 
+    // Design channel and audio filters for the configured rates, cached on disk
+    design::DesignCache filter_cache;
+    const std::vector<float> rf_taps = filter_cache.lowpass({(double)fs, 100e3, 30e3, 70.0});    // same spec as radio_taps
+    const bool rf_cached = filter_cache.last_hit();
+    // Low latency: the audio LPF goes minimum phase. The RF filter stays linear phase, its delay is
+    // ~0.1ms and phase distortion across the FM channel would turn into audio distortion.
+    const std::vector<float> af_taps = filter_cache.lowpass({(double)fq, 15e3, 3650.0, 69.0}, low_latency);   // same spec as audio_taps
+    std::cout << "Filters: RF " << rf_taps.size() << " taps, audio " << af_taps.size() << " taps"
+              << ((rf_cached && filter_cache.last_hit()) ? " (cached)" : " (designed)") << "\n";
+
     // Instantiate dsp blocks
-    FIRFilter<std::complex<float>> LPF(5, radio_taps);          // First stage LPF decimator
+    MultistagePlan first_plan = MultistagePlan::for_decimation(fs / fq, fs);
+    first_plan.halfband = halfband;
+    IqFrontEnd front_end = multistage ? IqFrontEnd(first_plan)  // uint8 IQ -> DC blocked, first stage decimator
+                                      : IqFrontEnd(fs / fq, rf_taps);
     StereoSeparator stereo(fq);                                 // Separates mono and stereo diff signals
-    RdsDecoder rds_decoder(static_cast<float>(fq));             // Decodes 57kHz RDS from MPX
-    FIRFilter<float> LPF_mono(10, audio_taps);                  // Second stage anti-aliasing LPF decimator - mono
-    FIRFilter<float> LPF_diff(10, audio_taps);                  // Second stage anti-aliasing LPF decimator - stereo diff
-    NotchFilter19k pilot_notch(fa);                             // 19kHz notch filter
-    FmDemod demod;                                              // demodulator
-    DeemphasisBiquad deemph_L(75e-6f, (float)fa);               // 1-pole IIR audio rate - L
-    DeemphasisBiquad deemph_R(75e-6f, (float)fa);               // 1-pole IIR audio rate - R
-    DcBlocker dc;                                               // audio DC blocker
-    IQDcBlocker iq_dc;                                          // IQ DC blocker
-    SimpleAgc agc;                                              // automatic gain control
+    std::atomic<bool> retune_pending{false};                    // UI retuned, the DSP thread restarts pilot acquisition
+    RdsDecoder rds_decoder(static_cast<float>(fq), rds_timing); // Decodes 57kHz RDS from MPX
+    StereoAudioStage audio_stage(fq / fa, af_taps, (float)fa, !low_latency);  // Second stage LPF decimator, notch, de-emphasis, L/R matrix
+    FmDemod demod(demod_mode);                                  // demodulator
+    BiquadBank<1> mpx_dc;                                       // audio DC blocker at the MPX rate
+    drift_comp = drift_comp && live_stream;                     // only a live sink has its own clock
+    PolyphaseResampler<ChannelFrame<2>> resampler(fa, fo, 15000.0, 80.0, drift_comp);   // L/R to the output rate, variable ratio for drift
+    AudioOutputStage output_stage;                              // automatic gain control, volume, soft clip
+
+    mpx_dc.add(DcBlocker((float)fq).coeffs());
+
+    {
+        // Report first stage cost for both layouts, tap multiplies per complex input sample
+        const IqFrontEnd fir_stage(fs / fq, rf_taps), multi_stage(first_plan);
+        std::cout << "Rate plan: " << rate_plan.describe() << "\n";
+        std::cout << "MPX rate: " << fq / 1000 << " kS/s\n";
+        std::cout << "First stage: " << front_end.describe() << "\n";
+        std::cout << "  MACs/sample  " << fir_stage.describe() << ": " << fir_stage.macs_per_input()
+                  << " | " << multi_stage.describe() << ": " << multi_stage.macs_per_input() << "\n";
+        std::cout << "Discriminator: " << (demod_mode == FmDemod::Mode::Atan2 ? "exact atan2"
+                                         : demod_mode == FmDemod::Mode::FastAtan2 ? "polynomial atan2"
+                                         : "quotient (I dQ - Q dI) / |x|^2") << "\n";
+        std::cout << "Second stage: " << (audio_stage.uses_fft() ? "overlap-save FFT" : "direct FIR")
+                  << " convolution, 2 lanes, " << af_taps.size() << " taps /" << fq / fa << "\n";
+        std::cout << "Output resampler: " << fa << " -> " << fo << " S/s, " << resampler.describe()
+                  << (drift_comp ? ", drift compensated" : "") << "\n";
+    }
 
     // IQ ring buffer for rtlsdr_async_read 
     CircularBuffer<uint8_t> iq_ring(1<<20);     // 1MB
     std::atomic<uint64_t> iq_dropped{0};
     AsyncContext actx{&iq_ring, &iq_dropped};   // Declare async context struct for buffer
 
+    // Pipeline buffering, the low latency profile trades USB / callback overhead for delay
+    const uint32_t usb_block = low_latency ? 4096 : 16384;             // bytes per async transfer and DSP block
+    const uint32_t usb_buffers = 15;                                    // async transfers queued in librtlsdr, its default
+    unsigned long framesPerBuffer = low_latency ? 256 : 1024;
+    const size_t max_prime_target = 1024 * 20;                          // interleaved samples, ~0.2s at 48k
+    const size_t min_prime_target = low_latency ? framesPerBuffer * 4 : max_prime_target;
+    size_t prime_target = min_prime_target;                             // adapts between the two on underruns
+
     // Audio ring buffer
     CircularBuffer<float> audio_ring(65536);      
-    std::vector<float> stereo_out_block(1024);          // interleaved (L,R) output block
-    std::vector<float> ws_out_block(1024);
+    std::vector<float> stereo_out_block(low_latency ? 2 * framesPerBuffer : 1024);     // interleaved (L,R) output block
+    std::vector<float> ws_out_block(stereo_out_block.size());
     int idx = 0;
     PaStream* stream = nullptr;
-    unsigned long framesPerBuffer = 1024;
     bool stream_started = false;
-    const size_t prime_target = framesPerBuffer * 20;    // ~0.4s
+    DriftCompensator drift(fo, prime_target / 2.0);       // holds the ring at the priming fill, in frames
 
     // Audio context for play/stop
     AudioContext audio_ctx;
@@ -222,7 +317,7 @@ int main(int argc, char* argv[]) {
     audio_ctx.is_playing = &stream_active;
 
     // Audio file buffer
-    const uint64_t target_audio = (uint64_t)fa * 10;    // 10 seconds
+    const uint64_t target_audio = (uint64_t)fo * 10;    // 10 seconds
     std::vector<float> audio;
     audio.reserve(target_audio * 2);
     int cnt = 0;
@@ -237,12 +332,6 @@ int main(int argc, char* argv[]) {
     ws_streamer.start();
 
 
-    // LUT for byte to float conversion
-    float lut[256];
-    for (int i = 0; i < 256; i++) {
-        lut[i] = (i - 127.5f) / 128.0f;
-    }
-
     // Set up PortAudio stream for live mode
     if (live_stream) {
         std::cout<<"Entering live streaming mode"<<std::endl;
@@ -252,21 +341,61 @@ int main(int argc, char* argv[]) {
             return 1;
         }
 
-        PaError err = Pa_OpenDefaultStream(
-            &stream,
-            0,                // no input
-            2,                // stereo output
-            paFloat32,
-            fa,
-            framesPerBuffer,
-            paCallback,
-            &audio_ctx        // userData
-        );
+        PaError err = paNoError;
+        const PaDeviceIndex out_dev = Pa_GetDefaultOutputDevice();
+        if (low_latency && out_dev != paNoDevice) {
+            // Default stream uses the device's high latency suggestion, ask for the low one
+            PaStreamParameters out_params{};
+            out_params.device = out_dev;
+            out_params.channelCount = 2;
+            out_params.sampleFormat = paFloat32;
+            out_params.suggestedLatency = Pa_GetDeviceInfo(out_dev)->defaultLowOutputLatency;
+            out_params.hostApiSpecificStreamInfo = nullptr;
+            err = Pa_OpenStream(&stream, nullptr, &out_params, fo, framesPerBuffer, paNoFlag, paCallback, &audio_ctx);
+        }
+        else {
+            err = Pa_OpenDefaultStream(
+                &stream,
+                0,                // no input
+                2,                // stereo output
+                paFloat32,
+                fo,
+                framesPerBuffer,
+                paCallback,
+                &audio_ctx        // userData
+            );
+        }
         if (err != paNoError) {
             std::cerr<<"PortAudio Open Stream Error: " << Pa_GetErrorText(err) << std::endl; 
         }
     }
 
+    {
+        // End-to-end latency budget: buffering at each hand-off plus filter group delays at DC
+        const PaStreamInfo* pa_info = stream ? Pa_GetStreamInfo(stream) : nullptr;
+        const std::vector<std::pair<std::string, double>> budget = {
+            {"USB transfer / IQ block", usb_block / 2.0 / fs},
+            {"First stage filter", front_end.group_delay() / fs},
+            {"Audio LPF", (design::group_delay(af_taps) + audio_stage.block_latency()) / fq},
+            {"Output resampler", resampler.group_delay() / fa},
+            {"Audio ring priming", live_stream ? prime_target / 2.0 / fo : 0.0},
+            {"PortAudio buffer", live_stream ? framesPerBuffer / (double)fo : 0.0},
+            {"PortAudio device", pa_info ? pa_info->outputLatency : 0.0},
+        };
+        double total = 0.0;
+        std::cout << "Latency budget (" << (low_latency ? "low latency" : "default") << " profile):\n";
+        for (const auto& [stage, seconds] : budget) {
+            char line[96];
+            std::snprintf(line, sizeof(line), "  %-24s %8.2f ms\n", stage.c_str(), 1e3 * seconds);
+            std::cout << line;
+            total += seconds;
+        }
+        char line[96];
+        std::snprintf(line, sizeof(line), "  %-24s %8.2f ms%s\n", "Total", 1e3 * total,
+                      low_latency ? " (priming adapts on underruns)" : "");
+        std::cout << line;
+    }
+
 
     // Instantiate UIApp struct 
     UiAppConfig cfg;
@@ -285,6 +414,7 @@ int main(int argc, char* argv[]) {
         uint32_t new_freq_hz = (uint32_t)(new_freq_mhz * 1e6);
         rtlsdr_set_center_freq(dev, new_freq_hz);  
         cfg.center_freq_hz = new_freq_hz; 
+        retune_pending.store(true, std::memory_order_release);
 
         // Set RF gain whenever at new center freq
         rtlsdr_set_tuner_gain(dev, rf_gain.load()); 
@@ -304,17 +434,34 @@ int main(int argc, char* argv[]) {
 
     // Start async reader
     std::thread reader([&]{
-        rtlsdr_read_async(dev, rtlsdr_async_cb, &actx, 0, 16384);
+        rtlsdr_read_async(dev, rtlsdr_async_cb, &actx, usb_buffers, usb_block);
 
         reader_finished.store(true, std::memory_order_release);
     });
 
     // Start thread for DSP pipeline
     std::thread dsp([&] {
-        std::vector<uint8_t> iqbuf(16384);
+        std::vector<uint8_t> iqbuf(usb_block);
+        std::vector<std::complex<float>> bb_block(iqbuf.size() / 2);     // MPX rate after first stage LPF
+        std::vector<float> mpx_block(bb_block.size());                   // demodulated MPX
+        std::vector<float> audio_mpx(bb_block.size());                   // MPX after audio DC blocking
+        std::vector<ChannelFrame<2>> sep_block(bb_block.size());         // mono + stereo diff at the MPX rate
+        std::vector<ChannelFrame<2>> lr_block(bb_block.size());          // 48kS/s L/R
+        const size_t out_size = std::max(bb_block.size(), resampler.max_output(bb_block.size()));
+        std::vector<ChannelFrame<2>> rs_block(out_size);                 // L/R at the output rate
+        std::vector<float> monitor_block(2 * out_size);                  // interleaved L/R after AGC
+        std::vector<float> out_block(2 * out_size);                      // interleaved L/R after volume and soft clip
+        double stereo_path_ns = 0.0, mono_path_ns = 0.0;                 // separator + LPF cost per MPX sample
         std::vector<float> outBlock(512);
         size_t outCount = 0;
         double last_rds_publish = 0.0;
+        uint64_t rds_json_version = 0;                                   // snapshot version rds_json was built from
+        std::string rds_json;
+        double last_drift_log = 0.0;
+        double last_prime_change = 0.0;
+        uint64_t seen_underruns = 0;
+        int seen_locks = 0;
+        std::vector<float> silence;
 
         while (!reader_finished.load(std::memory_order_acquire) || iq_ring.read_available() > 0) {
 
@@ -341,98 +488,147 @@ int main(int argc, char* argv[]) {
                 raw_dump.write(reinterpret_cast<char*>(iqbuf.data()), n);
             }
 
-            // n_read bytes, interleaved I,Q
-            for (int i = 0; i + 1 < n; i += 2) {
-                float I = lut[iqbuf[i]];
-                float Q = lut[iqbuf[i+1]];
-                std::complex<float> x(I, Q);
-                std::complex<float> x1;
-                iq_dc.process(x);                       // IQ DC blocker
-
-                // Push to FFT ring buffer for visualizer
-                rf_block.push_back(x.real());
-                rf_block.push_back(x.imag());
-                if (rf_block.size() == NFFT * 2) {
-                    size_t written = fft_ring.push(rf_block.data(), rf_block.size());
-                    rf_block.clear();
-                }
-
-                if (!LPF.Filter(x,x1)) continue;        // First stage LPF 
+            // n_read bytes, interleaved I,Q - fused conversion and first stage LPF decimation to the MPX rate
+            const std::complex<float> iq_dc = front_end.dc();
+            size_t bb_count = front_end.process(std::span<const uint8_t>(iqbuf.data(), n), bb_block,
+                [&](const std::complex<float>* x, size_t count) {
+                    // Push to FFT ring buffer for visualizer
+                    for (size_t i = 0; i < count; i++) {
+                        rf_block.push_back(x[i].real() - iq_dc.real());
+                        rf_block.push_back(x[i].imag() - iq_dc.imag());
+                        if (rf_block.size() == NFFT * 2) {
+                            size_t written = fft_ring.push(rf_block.data(), rf_block.size());
+                            rf_block.clear();
+                        }
+                    }
+                });
 
-                float fm = demod.push(x1);              // demodulate
-                fm = std::clamp(fm, -limit, limit);     // remove bad phase jumps
-                float fm_rds = fm;                      // Preserve MPX before audio DC blocking for RDS
-                fm = dc.push(fm);                       // audio DC blocker 
+            // demodulate the whole block
+            demod.process(std::span<const std::complex<float>>(bb_block.data(), bb_count), mpx_block);
 
-                auto [raw_mono, raw_diff] = stereo.process(fm);     // stereo separator - 480kS/s
-                rds_decoder.process(fm_rds, stereo.phase);          // RDS decoder - 57kHz subcarrier
+            for (size_t j = 0; j < bb_count; j++) {
+                mpx_block[j] = std::clamp(mpx_block[j], -limit, limit);    // remove bad phase jumps
+            }
+            std::copy(mpx_block.begin(), mpx_block.begin() + bb_count, audio_mpx.begin());
+            mpx_dc.process(std::span<float>(audio_mpx.data(), bb_count));  // audio DC blocker, RDS keeps the raw MPX
+
+            // stereo separator - MPX rate, publishes the pilot NCO carriers for the block. A retune restarts
+            // the seeded pilot acquisition, each completed acquisition reports its lock time. This block, the
+            // IQ ring and the transfers in flight still hold the old station, the acquisition skips them
+            if (retune_pending.exchange(false, std::memory_order_acq_rel)) {
+                const size_t queued_iq = (iq_ring.read_available() + (size_t)usb_buffers * usb_block) / 2;
+                stereo.reacquire(bb_count + queued_iq / (fs / fq));
+            }
+            const auto t_sep = std::chrono::steady_clock::now();
+            stereo.process(std::span<const float>(audio_mpx.data(), bb_count), sep_block);
+            double path_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t_sep).count();
+            if (stereo.locks != seen_locks) {
+                seen_locks = stereo.locks;
+                std::cout << "Pilot locked at " << stereo.pilot.freq << " Hz in " << stereo.lock_ms << " ms" << std::endl;
+            }
+            rds_decoder.process(std::span<const float>(mpx_block.data(), bb_count), stereo.carriers());   // RDS decoder - 57kHz subcarrier
 
-                double t_now = now_seconds();
-                if (t_now - last_rds_publish >= 0.5) {
+            double t_now = now_seconds();
+            if (t_now - last_rds_publish >= 0.5) {
+                // JSON is rebuilt only for a new snapshot version, late joining clients still get it resent
+                if (rds_decoder.version() != rds_json_version) {
                     RdsSnapshot rds = rds_decoder.snapshot();
                     nlohmann::json payload{
                         {"synced", rds.synced},
-                        {"pi", rds.pi},
-                        {"programService", rds.program_service},
-                        {"radioText", rds.radio_text},
+                        {"pi", rds.pi.c_str()},
+                        {"programService", rds.program_service.c_str()},
+                        {"radioText", rds.radio_text.c_str()},
                         {"groups", rds.groups},
-                        {"blocks", rds.blocks}
+                        {"blocks", rds.blocks},
+                        {"stereo", rds.stereo},
+                        {"pilotDb", rds.pilot_db},
+                        {"monoSaving", rds.mono_saving}
                     };
-                    ws_streamer.publishRds(payload.dump());
-                    last_rds_publish = t_now;
+                    rds_json = payload.dump();
+                    rds_json_version = rds.version;
                 }
+                ws_streamer.publishRds(rds_json);
+                last_rds_publish = t_now;
+            }
 
-                float mono_out, diff_out;
-                bool mono_ready = LPF_mono.Filter(raw_mono, mono_out);  // Second stage LPF - mono - 48kS/s
-                bool diff_ready = LPF_diff.Filter(raw_diff, diff_out);  // Second stage LPF - diff - 48kS/s
-
-                if (mono_ready && diff_ready) {
-                    mono_out = pilot_notch.push(mono_out);      // Notch filter 19kHz
-
-                    float left = (mono_out + diff_out);         // Matrix L+R
-                    float right = (mono_out - diff_out);
-
-                    left = deemph_L.push(left);                 // Deemphasis IIR L+R
-                    right = deemph_R.push(right);
-
-                    left = agc.apply(left);             // Automatic gain control
-                    right = agc.apply(right);
-
-                    float left_c = left;
-                    float right_c = right;
+            // Second stage - 48kS/s L/R: 2-lane LPF decimator, notch + de-emphasis bank, matrix. It runs in both
+            // modes on the separator output (L-R = 0 while mono), so a pilot change neither clicks nor replays stale audio
+            const bool stereo_mode = stereo.is_stereo;
+            const auto t_lpf = std::chrono::steady_clock::now();
+            const size_t audio_count = audio_stage.process(std::span<const ChannelFrame<2>>(sep_block.data(), bb_count), lr_block);
+            path_ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t_lpf).count();
+
+            // Smoothed cost per MPX sample of each mode, the saving is known once both were seen
+            double& mode_ns = stereo_mode ? stereo_path_ns : mono_path_ns;
+            const double block_ns = path_ns / std::max<size_t>(bb_count, 1);
+            mode_ns = (mode_ns == 0.0) ? block_ns : 0.9 * mode_ns + 0.1 * block_ns;
+            const float mono_saving = (stereo_path_ns > 0.0 && mono_path_ns > 0.0) ? (float)(1.0 - mono_path_ns / stereo_path_ns) : -1.0f;
+            rds_decoder.setStereoStatus(stereo_mode, stereo.pilot_lock_level, mono_saving);
+
+            // Polyphase resampler to the output rate, AGC and volume then run at the sink rate
+            std::span<const ChannelFrame<2>> sink_block(lr_block.data(), audio_count);
+            if (!resampler.bypass()) {
+                sink_block = std::span<const ChannelFrame<2>>(rs_block.data(), resampler.process(sink_block, rs_block));
+            }
+            const size_t out_count = sink_block.size();
 
-                    float volume_knob = volume_level.load(std::memory_order_relaxed);   // Volume control
-                    left *= volume_knob;
-                    right *= volume_knob;
+            const float volume_knob = volume_level.load(std::memory_order_relaxed);   // Volume control
+            output_stage.process(sink_block, volume_knob, monitor_block, out_block);
 
-                    left = softclip(left);              // soft clip
-                    right = softclip(right);
+            if (live_stream) {
+                // Start stream after buffer has been filled to initial target
+                if (!stream_started && audio_ring.read_available() >= prime_target) {
+                    Pa_StartStream(stream);
+                    stream_started = true;
+                }
 
-                    if (live_stream) {
-                        // Start stream after buffer has been filled to initial target
-                        if (!stream_started && audio_ring.read_available() >= prime_target) {
-                            Pa_StartStream(stream);
-                            stream_started = true;
-                        }
+                for (size_t k = 0; k < 2 * out_count; k++) {
+                    ws_out_block[idx] = monitor_block[k];
+                    stereo_out_block[idx++] = out_block[k];     // Push to interleaved stereo buffer
+                    if (idx == stereo_out_block.size()) {
+                        audio_ring.push(stereo_out_block.data(), idx);
+                        ws_streamer.publishAudioPcm16(ws_out_block.data(), idx);        // websockets
+                        idx = 0;
+                    }
+                }
 
-                        ws_out_block[idx] = left_c;
-                        stereo_out_block[idx++] = left;     // Push to interleaved stereo buffer
-                        ws_out_block[idx] = right_c;
-                        stereo_out_block[idx++] = right;
-                        if (idx == stereo_out_block.size()) {
-                            audio_ring.push(stereo_out_block.data(), idx);
-                            ws_streamer.publishAudioPcm16(ws_out_block.data(), idx);        // websockets
-                            idx = 0;
+                // Adaptive priming: an underrun raises the target and refills the ring with silence right
+                // away, every quiet minute lowers it a step, the drift loop glides the fill down to it
+                if (low_latency && stream_started) {
+                    const uint64_t underruns = g_underruns.load(std::memory_order_relaxed);
+                    if (underruns != seen_underruns) {
+                        seen_underruns = underruns;
+                        prime_target = std::min(max_prime_target, (prime_target * 3 / 2) & ~(size_t)1);
+                        const size_t fill = audio_ring.read_available();
+                        if (fill < prime_target) {
+                            silence.assign(prime_target - fill, 0.0f);
+                            audio_ring.push(silence.data(), silence.size());
                         }
+                        last_prime_change = t_now;
                     }
-                    else {
-                        audio.push_back(left);
-                        audio.push_back(right);
-                        if (audio.size() >= target_audio * 2) {
-                            running.store(false, std::memory_order_relaxed);
-                            break;
-                        }
+                    else if (t_now - last_prime_change >= 60.0 && prime_target > min_prime_target) {
+                        prime_target = std::max(min_prime_target, (prime_target * 9 / 10) & ~(size_t)1);
+                        last_prime_change = t_now;
                     }
+                    drift.set_target(prime_target / 2.0);
+                }
+
+                // Clock drift: trim the resampler ratio so the ring fill stays at the priming target
+                if (drift_comp && stream_started) {
+                    const double fill = (audio_ring.read_available() + idx) / 2.0;
+                    resampler.set_ratio_scale(drift.update(out_count, fill, stereo.pilot.freq, stereo_mode));
+                    if (t_now - last_drift_log >= 30.0) {
+                        std::cout << "Drift: " << drift.describe() << ", underruns " << g_underruns.load() << std::endl;
+                        drift.reset_stats();
+                        last_drift_log = t_now;
+                    }
+                }
+            }
+            else {
+                audio.insert(audio.end(), out_block.begin(), out_block.begin() + 2 * out_count);
+                if (audio.size() >= target_audio * 2) {
+                    audio.resize(target_audio * 2);
+                    running.store(false, std::memory_order_relaxed);
                 }
             }
 
@@ -537,6 +733,9 @@ int main(int argc, char* argv[]) {
 
 
     if (live_stream) {
+        std::cout << "Audio underruns: " << g_underruns.load();
+        if (drift_comp) std::cout << " | drift " << drift.describe();
+        std::cout << std::endl;
         Pa_StopStream(stream);
         Pa_CloseStream(stream);
         Pa_Terminate();  
@@ -548,7 +747,7 @@ int main(int argc, char* argv[]) {
         AudioFile<float> wav;
         wav.setNumChannels(2);
         wav.setNumSamplesPerChannel((int)audio.size()/2);    // 10 seconds
-        wav.setSampleRate(fa);
+        wav.setSampleRate(fo);
 
         for (size_t i = 0; i < audio.size(); i += 2) {
             wav.samples[0][i/2] = audio[i];